@@ -28,7 +28,17 @@ SOFTWARE.
 
 
 #include <iostream>
+#include <sstream>
+#include <iomanip>
 #include <vector>
+#include <array>
+#include <limits>
+#include <type_traits>
+#include <cstring>
+#include <charconv>
+
+// not ctime as we need gmtime_s
+#include <time.h>
 
 #include "boost/json.hpp"
 
@@ -36,10 +46,58 @@ SOFTWARE.
 #include "crypto-exchange-client-core/exception.hpp"
 #include "crypto-exchange-client-core/apiMessage.hpp"
 
+#include "crypto-exchange-client-huobi/json.hpp"
+
 
 namespace as::cryptox::huobi {
 
-	class ApiMessage : public ::as::cryptox::ApiMessage<ApiMessage> {};
+	class ApiMessage : public ::as::cryptox::ApiMessage<ApiMessage> {
+	public:
+		/// UTC, as expected by the request signatures; ts is ms since epoch
+		static as::t_string Timestamp( int64_t ts )
+		{
+			time_t t = static_cast<time_t>( ts / 1000 );
+			struct tm tm;
+
+#if defined( _MSC_VER )
+			gmtime_s( &tm, &t );
+#else
+			gmtime_r( &t, &tm );
+#endif
+
+			std::stringstream ss;
+			ss << std::put_time( &tm, "%FT%T" );
+
+			return ss.str();
+		}
+
+	protected:
+		/// parses s into document; throws name unless it is an object with
+		/// "status": "ok"
+		static JsonValue & okRoot( JsonDocument & document,
+			const ::as::t_string & s,
+			const as::t_char * name )
+		{
+
+			std::string_view status;
+
+			if ( !document.parse( s ) ||
+				!document.Root().stringField( "status", status ) ||
+				"ok" != status ) {
+
+				throw ::as::Exception( name );
+			}
+
+			return document.Root();
+		}
+
+		static void require( bool isOk, const as::t_char * name )
+		{
+			if ( !isOk ) {
+				throw ::as::Exception( name );
+			}
+		}
+	};
 
 	class ApiRequest : public ApiMessage {
 	public:
@@ -48,6 +106,27 @@ namespace as::cryptox::huobi {
 			return AS_T( "/v2/settings/common/symbols" );
 		}
 
+		static as::t_string CommonTimestamp()
+		{
+			return AS_T( "/v1/common/timestamp" );
+		}
+
+		static as::t_string MarketTickers()
+		{
+			return AS_T( "/market/tickers" );
+		}
+
+		static as::t_string AccountAccounts()
+		{
+			return AS_T( "/v1/account/accounts" );
+		}
+
+		static as::t_string AccountBalance( int64_t accountId )
+		{
+			return AS_T( "/v1/account/accounts/" ) + AS_TOSTRING( accountId ) +
+				AS_T( "/balance" );
+		}
+
 		static as::t_string Buy( const as::t_stringview & symbolName,
 			const FixedNumber & price,
 			const FixedNumber & quantity )
@@ -85,30 +164,41 @@ namespace as::cryptox::huobi {
 			const ::as::t_string & s )
 		{
 
-			auto v = boost::json::parse( s );
-			auto & o = v.get_object();
+			auto name = AS_T( "ApiResponseSettingsCommonSymbols" );
 
-			if ( !o.contains( "status" ) || o["status"].get_string() != "ok" ) {
-				throw ::as::Exception(
-					AS_T( "ApiResponseSettingsCommonSymbols" ) );
-			}
+			JsonDocument document;
+			JsonValue data;
+			bool isOk = true;
+
+			require( okRoot( document, s, name ).field( "data", data ), name );
 
 			ApiResponseSettingsCommonSymbols result;
 
-			for ( const auto & e : o["data"].get_array() ) {
-				auto & s = e.get_object();
+			isOk = data.forEach( [&]( JsonValue & e ) {
+				std::string_view state;
+				std::string_view symbolName;
+				std::string_view baseName;
+				std::string_view quoteName;
+
+				if ( !e.stringField( "state", state ) ||
+					!e.stringField( "sc", symbolName ) ||
+					!e.stringField( "bc", baseName ) ||
+					!e.stringField( "qc", quoteName ) ) {
 
-				if ( s.at( "state" ).get_string() != "online" ) {
-					continue;
+					isOk = false;
+					return false;
 				}
 
-				Pair pair;
-				pair.name.assign( s.at( "sc" ).get_string() );
-				pair.baseName.assign( s.at( "bc" ).get_string() );
-				pair.quoteName.assign( s.at( "qc" ).get_string() );
+				if ( "online" == state ) {
+					result.m_pairs.push_back( { as::t_string( symbolName ),
+						as::t_string( baseName ),
+						as::t_string( quoteName ) } );
+				}
 
-				result.m_pairs.push_back( std::move( pair ) );
-			}
+				return true;
+			} ) && isOk;
+
+			require( isOk, name );
 
 			return result;
 		}
@@ -119,6 +209,621 @@ namespace as::cryptox::huobi {
 		}
 	};
 
+	class ApiResponseCommonTimestamp : public ApiMessage {
+	protected:
+		int64_t m_ts{ 0 };
+
+	public:
+		static ApiResponseCommonTimestamp deserialize(
+			const ::as::t_string & s )
+		{
+
+			auto name = AS_T( "ApiResponseCommonTimestamp" );
+
+			JsonDocument document;
+			ApiResponseCommonTimestamp result;
+
+			auto & v = okRoot( document, s, name );
+
+			require( v.int64Field( "data", result.m_ts ), name );
+
+			return result;
+		}
+
+		/// server time, ms since epoch
+		int64_t Ts() const
+		{
+			return m_ts;
+		}
+	};
+
+	/// 24h tickers of all the symbols, stored column-wise and indexed by
+	/// symbol; rows for symbols which did not come are NaN
+	///
+	/// the response is parsed straight into the columns, no DOM and no
+	/// per-row strings: by a streaming parser with Boost.JSON, on demand
+	/// with simdjson
+	class ApiResponseMarketTickers : public ApiMessage {
+	public:
+		static const size_t ColumnOpen = 0;
+		static const size_t ColumnHigh = 1;
+		static const size_t ColumnLow = 2;
+		static const size_t ColumnClose = 3;
+		static const size_t ColumnAmount = 4;
+		static const size_t ColumnVol = 5;
+		static const size_t ColumnTradeCount = 6;
+		static const size_t ColumnBid = 7;
+		static const size_t ColumnBidSize = 8;
+		static const size_t ColumnAsk = 9;
+		static const size_t ColumnAskSize = 10;
+		static const size_t ColumnCount = 11;
+
+	protected:
+		/// the key of a column in a row of the response
+		static const char * columnName( size_t column )
+		{
+			static const char * Names[ColumnCount] = { "open",
+				"high",
+				"low",
+				"close",
+				"amount",
+				"vol",
+				"count",
+				"bid",
+				"bidSize",
+				"ask",
+				"askSize" };
+
+			return Names[column];
+		}
+
+		template <typename TSymbolResolver> class Handler {
+		protected:
+			static const size_t MaxNameSize = 32;
+			static const size_t ColumnSymbol = ColumnCount;
+			static const size_t ColumnStatus = ColumnCount + 1;
+			static const size_t ColumnData = ColumnCount + 2;
+			static const size_t ColumnNone = ColumnCount + 3;
+
+		protected:
+			ApiResponseMarketTickers & m_result;
+			TSymbolResolver & m_toSymbolIndex;
+
+			size_t m_depth{ 0 };
+			bool m_isInData{ false };
+			bool m_isOk{ false };
+			size_t m_column{ ColumnNone };
+
+			char m_name[MaxNameSize + 1];
+			size_t m_nameSize{ 0 };
+			bool m_isNameTruncated{ false };
+
+			std::array<double, ColumnCount> m_row;
+			size_t m_rowIndex{ 0 };
+
+		protected:
+			static size_t toColumn( boost::json::string_view key )
+			{
+				switch ( key.size() ) {
+					case 3:
+						return key == "low"
+							? ColumnLow
+							: ( key == "vol"
+									  ? ColumnVol
+									  : ( key == "bid"
+												? ColumnBid
+												: ( key == "ask" ? ColumnAsk
+																 : ColumnNone ) ) );
+
+					case 4:
+						return key == "open"
+							? ColumnOpen
+							: ( key == "high"
+									  ? ColumnHigh
+									  : ( key == "data" ? ColumnData
+														: ColumnNone ) );
+
+					case 5:
+						return key == "close"
+							? ColumnClose
+							: ( key == "count" ? ColumnTradeCount : ColumnNone );
+
+					case 6:
+						return key == "amount"
+							? ColumnAmount
+							: ( key == "symbol"
+									  ? ColumnSymbol
+									  : ( key == "status" ? ColumnStatus
+														  : ColumnNone ) );
+
+					case 7:
+						return key == "bidSize"
+							? ColumnBidSize
+							: ( key == "askSize" ? ColumnAskSize
+												 : ColumnNone );
+				}
+
+				return ColumnNone;
+			}
+
+			/// keys and strings longer than MaxNameSize are no symbol or
+			/// key of ours, they are truncated and then match nothing
+			void appendName( boost::json::string_view s )
+			{
+				if ( s.size() > MaxNameSize - m_nameSize ) {
+					s = s.substr( 0, MaxNameSize - m_nameSize );
+					m_isNameTruncated = true;
+				}
+
+				std::memcpy( m_name + m_nameSize, s.data(), s.size() );
+				m_nameSize += s.size();
+				m_name[m_nameSize] = 0;
+			}
+
+			void clearName()
+			{
+				m_nameSize = 0;
+				m_isNameTruncated = false;
+			}
+
+			bool onNumber( double n )
+			{
+				if ( m_isInData && m_depth == 3 && m_column < ColumnCount ) {
+					m_row[m_column] = n;
+				}
+
+				m_column = ColumnNone;
+
+				return true;
+			}
+
+		public:
+			static constexpr std::size_t max_object_size = std::size_t( -1 );
+			static constexpr std::size_t max_array_size = std::size_t( -1 );
+			static constexpr std::size_t max_key_size = std::size_t( -1 );
+			static constexpr std::size_t max_string_size = std::size_t( -1 );
+
+		public:
+			Handler( ApiResponseMarketTickers & result,
+				TSymbolResolver & toSymbolIndex )
+				: m_result( result )
+				, m_toSymbolIndex( toSymbolIndex )
+			{
+			}
+
+			bool IsOk() const
+			{
+				return m_isOk;
+			}
+
+			bool on_document_begin( boost::json::error_code & )
+			{
+				return true;
+			}
+
+			bool on_document_end( boost::json::error_code & )
+			{
+				return true;
+			}
+
+			bool on_array_begin( boost::json::error_code & )
+			{
+				m_isInData = m_depth == 1 && m_column == ColumnData;
+				m_column = ColumnNone;
+				m_depth++;
+
+				return true;
+			}
+
+			bool on_array_end( std::size_t, boost::json::error_code & )
+			{
+				m_depth--;
+				m_isInData = false;
+
+				return true;
+			}
+
+			bool on_object_begin( boost::json::error_code & )
+			{
+				m_depth++;
+
+				if ( m_isInData && m_depth == 3 ) {
+					m_row.fill( std::numeric_limits<double>::quiet_NaN() );
+					m_rowIndex = 0;
+				}
+
+				m_column = ColumnNone;
+
+				return true;
+			}
+
+			bool on_object_end( std::size_t, boost::json::error_code & )
+			{
+				if ( m_isInData && m_depth == 3 && m_rowIndex > 0 &&
+					m_rowIndex < m_result.m_size ) {
+
+					for ( size_t i = 0; i < ColumnCount; i++ ) {
+						m_result.m_columns[i][m_rowIndex] = m_row[i];
+					}
+				}
+
+				m_depth--;
+
+				return true;
+			}
+
+			bool on_string_part( boost::json::string_view s,
+				std::size_t,
+				boost::json::error_code & )
+			{
+
+				if ( m_column != ColumnNone ) {
+					appendName( s );
+				}
+
+				return true;
+			}
+
+			bool on_string( boost::json::string_view s,
+				std::size_t,
+				boost::json::error_code & )
+			{
+
+				if ( m_column == ColumnNone ) {
+					return true;
+				}
+
+				appendName( s );
+
+				if ( m_column == ColumnSymbol && m_isInData && m_depth == 3 ) {
+					// no symbol is that long, the row is skipped
+					m_rowIndex = m_isNameTruncated
+						? 0
+						: m_toSymbolIndex(
+							  std::string_view( m_name, m_nameSize ) );
+				}
+				else if ( m_column == ColumnStatus && m_depth == 1 ) {
+					m_isOk = !m_isNameTruncated &&
+						std::strcmp( m_name, "ok" ) == 0;
+				}
+
+				m_column = ColumnNone;
+				clearName();
+
+				return true;
+			}
+
+			bool on_key_part( boost::json::string_view s,
+				std::size_t,
+				boost::json::error_code & )
+			{
+
+				appendName( s );
+				return true;
+			}
+
+			bool on_key( boost::json::string_view s,
+				std::size_t,
+				boost::json::error_code & )
+			{
+
+				appendName( s );
+
+				m_column = m_isNameTruncated
+					? ColumnNone
+					: toColumn( { m_name, m_nameSize } );
+				clearName();
+
+				return true;
+			}
+
+			bool on_number_part( boost::json::string_view,
+				boost::json::error_code & )
+			{
+
+				return true;
+			}
+
+			bool on_int64( int64_t n,
+				boost::json::string_view,
+				boost::json::error_code & )
+			{
+
+				return onNumber( static_cast<double>( n ) );
+			}
+
+			bool on_uint64( uint64_t n,
+				boost::json::string_view,
+				boost::json::error_code & )
+			{
+
+				return onNumber( static_cast<double>( n ) );
+			}
+
+			bool on_double( double n,
+				boost::json::string_view,
+				boost::json::error_code & )
+			{
+
+				return onNumber( n );
+			}
+
+			bool on_bool( bool, boost::json::error_code & )
+			{
+				m_column = ColumnNone;
+				return true;
+			}
+
+			bool on_null( boost::json::error_code & )
+			{
+				m_column = ColumnNone;
+				return true;
+			}
+
+			bool on_comment_part(
+				boost::json::string_view, boost::json::error_code & )
+			{
+
+				return true;
+			}
+
+			bool on_comment(
+				boost::json::string_view, boost::json::error_code & )
+			{
+
+				return true;
+			}
+		};
+
+	protected:
+		size_t m_size{ 0 };
+		std::array<std::vector<double>, ColumnCount> m_columns;
+
+	public:
+		/// toSymbolIndex( std::string_view name ) returns the symbol index,
+		/// or 0 if the symbol is unknown, and must not throw; symbolCount is
+		/// the size of the columns, rows of unknown symbols are skipped
+		template <typename TSymbolResolver>
+		static ApiResponseMarketTickers deserialize( const ::as::t_string & s,
+			size_t symbolCount,
+			TSymbolResolver && toSymbolIndex )
+		{
+
+			ApiResponseMarketTickers result;
+			result.m_size = symbolCount;
+
+			for ( auto & column : result.m_columns ) {
+				column.assign(
+					symbolCount, std::numeric_limits<double>::quiet_NaN() );
+			}
+
+#if defined( AS_HUOBI_JSON_SIMDJSON )
+			auto name = AS_T( "ApiResponseMarketTickers" );
+
+			JsonDocument document;
+			JsonValue data;
+			bool isOk = true;
+
+			require( okRoot( document, s, name ).field( "data", data ), name );
+
+			isOk = data.forEach( [&]( JsonValue & e ) {
+				std::string_view symbolName;
+
+				if ( !e.stringField( "symbol", symbolName ) ) {
+					isOk = false;
+					return false;
+				}
+
+				size_t rowIndex = toSymbolIndex( symbolName );
+
+				if ( 0 == rowIndex || rowIndex >= result.m_size ) {
+					return true;
+				}
+
+				// in the order they are sent, a missing or non-number one is
+				// left NaN
+				for ( size_t i = 0; i < ColumnCount; i++ ) {
+					double n;
+
+					if ( e.doubleField( columnName( i ), n ) ) {
+						result.m_columns[i][rowIndex] = n;
+					}
+				}
+
+				return true;
+			} ) && isOk;
+
+			require( isOk, name );
+#else
+			boost::json::basic_parser<
+				Handler<std::remove_reference_t<TSymbolResolver>>>
+				parser( boost::json::parse_options(), result, toSymbolIndex );
+
+			boost::json::error_code ec;
+			parser.write_some( false, s.data(), s.size(), ec );
+
+			if ( ec || !parser.handler().IsOk() ) {
+				throw ::as::Exception( AS_T( "ApiResponseMarketTickers" ) );
+			}
+#endif
+
+			return result;
+		}
+
+		size_t Size() const
+		{
+			return m_size;
+		}
+
+		/// indexed by symbol
+		const std::vector<double> & Column( size_t column ) const
+		{
+			return m_columns[column];
+		}
+	};
+
+	class ApiResponseAccountAccounts : public ApiMessage {
+	public:
+		struct Account {
+			int64_t id;
+			as::t_string type;
+		};
+
+	protected:
+		std::vector<Account> m_accounts;
+
+	public:
+		static ApiResponseAccountAccounts deserialize(
+			const ::as::t_string & s )
+		{
+			auto name = AS_T( "ApiResponseAccountAccounts" );
+
+			JsonDocument document;
+			JsonValue data;
+			bool isOk = true;
+
+			require( okRoot( document, s, name ).field( "data", data ), name );
+
+			ApiResponseAccountAccounts result;
+
+			isOk = data.forEach( [&]( JsonValue & e ) {
+				int64_t id;
+				std::string_view type;
+				std::string_view state;
+
+				if ( !e.int64Field( "id", id ) ||
+					!e.stringField( "type", type ) ||
+					!e.stringField( "state", state ) ) {
+
+					isOk = false;
+					return false;
+				}
+
+				if ( "working" == state ) {
+					result.m_accounts.push_back( { id, as::t_string( type ) } );
+				}
+
+				return true;
+			} ) && isOk;
+
+			require( isOk, name );
+
+			return result;
+		}
+
+		const std::vector<Account> & Accounts() const
+		{
+			return m_accounts;
+		}
+
+		/// 0 if there is none
+		int64_t SpotAccountId() const
+		{
+			for ( const auto & a : m_accounts ) {
+				if ( a.type == AS_T( "spot" ) ) {
+					return a.id;
+				}
+			}
+
+			return 0;
+		}
+	};
+
+	class ApiResponseAccountBalance : public ApiMessage {
+	public:
+		struct Balance {
+			as::t_string currencyName;
+			double balance;
+			double available;
+		};
+
+	protected:
+		std::vector<Balance> m_balances;
+
+	public:
+		static ApiResponseAccountBalance deserialize( const ::as::t_string & s )
+		{
+			auto name = AS_T( "ApiResponseAccountBalance" );
+
+			JsonDocument document;
+			JsonValue data;
+			JsonValue list;
+			bool isOk = true;
+
+			require( okRoot( document, s, name ).field( "data", data ) &&
+					data.field( "list", list ),
+				name );
+
+			ApiResponseAccountBalance result;
+
+			// one entry per currency and type, "trade" is what is available,
+			// "frozen" is locked in orders; the other types (loan, interest
+			// and the like) are not part of the balance
+			isOk = list.forEach( [&]( JsonValue & e ) {
+				std::string_view currencyName;
+				std::string_view type;
+				std::string_view amountS;
+				double amount;
+
+				if ( !e.stringField( "currency", currencyName ) ||
+					!e.stringField( "type", type ) ||
+					!e.stringField( "balance", amountS ) ) {
+
+					isOk = false;
+					return false;
+				}
+
+				auto end = amountS.data() + amountS.size();
+
+				if ( std::from_chars( amountS.data(), end, amount ).ec !=
+					std::errc() ) {
+
+					isOk = false;
+					return false;
+				}
+
+				bool isTrade = "trade" == type;
+
+				if ( !isTrade && "frozen" != type ) {
+					return true;
+				}
+
+				Balance * balance = nullptr;
+
+				for ( auto & r : result.m_balances ) {
+					if ( r.currencyName == currencyName ) {
+						balance = &r;
+						break;
+					}
+				}
+
+				if ( nullptr == balance ) {
+					result.m_balances.push_back(
+						{ as::t_string( currencyName ), 0, 0 } );
+
+					balance = &result.m_balances.back();
+				}
+
+				if ( isTrade ) {
+					balance->available += amount;
+				}
+
+				balance->balance += amount;
+
+				return true;
+			} ) && isOk;
+
+			require( isOk, name );
+
+			return result;
+		}
+
+		const std::vector<Balance> & Balances() const
+		{
+			return m_balances;
+		}
+	};
+
 	class ApiResponseOrders : public ApiMessage {
 	protected:
 		::as::t_string m_orderId;
@@ -126,16 +831,20 @@ namespace as::cryptox::huobi {
 	public:
 		static ApiResponseOrders deserialize( const ::as::t_string & s )
 		{
-			auto v = boost::json::parse( s );
-			auto & o = v.get_object();
+			auto name = AS_T( "ApiResponseOrders" );
 
-			if ( o.contains( "error" ) ) {
-				throw ::as::Exception( AS_T( "ApiResponseOrders" ) );
-			}
+			JsonDocument document;
+			JsonValue error;
+			std::string_view orderId;
+
+			require( document.parse( s ), name );
+			require( !document.Root().field( "error", error ), name );
+			require(
+				document.Root().stringField( "orderNumber", orderId ), name );
 
 			ApiResponseOrders result;
 
-			result.m_orderId.assign( o["orderNumber"].get_string() );
+			result.m_orderId.assign( orderId );
 
 			return result;
 		}
@@ -0,0 +1,165 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// asyncHttpClient.hpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#ifndef __CRYPTO_EXCHANGE_CLIENT_HUOBI__ASYNC_HTTP_CLIENT__H
+#define __CRYPTO_EXCHANGE_CLIENT_HUOBI__ASYNC_HTTP_CLIENT__H
+
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "boost/asio.hpp"
+#include "boost/asio/ssl.hpp"
+#include "boost/beast/http.hpp"
+
+#include "crypto-exchange-client-core/core.hpp"
+
+
+namespace as::cryptox::huobi {
+
+	/// error category for non-2xx http responses, the value is the status
+	const boost::system::error_category & httpStatusCategory();
+
+	/// keep-alive https client with a small connection pool per host and
+	/// request pipelining
+	///
+	/// requests may be submitted from any thread, all the io and the
+	/// completions happen on the given io_context
+	class AsyncHttpClient {
+	public:
+		using t_header_list =
+			std::vector<std::pair<as::t_string, as::t_string>>;
+
+		using t_handler =
+			std::function<void( boost::system::error_code, std::string )>;
+
+	protected:
+		class Connection;
+
+		struct t_request {
+			as::t_string host;
+			boost::beast::http::request<boost::beast::http::string_body>
+				message;
+			t_handler handler;
+		};
+
+	protected:
+		boost::asio::io_context & m_ioContext;
+		boost::asio::ssl::context m_sslContext;
+		size_t m_maxConnectionCount;
+		size_t m_maxPipelineDepth;
+
+		// io_context thread only
+		std::map<as::t_string, std::vector<std::shared_ptr<Connection>>>
+			m_pools;
+
+	protected:
+		void enqueue( std::shared_ptr<t_request> request );
+
+		/// completion handlers may be move-only and get invoked on their
+		/// associated executor
+		template <typename Handler> t_handler wrapHandler( Handler && handler )
+		{
+			auto h = std::make_shared<std::decay_t<Handler>>(
+				std::forward<Handler>( handler ) );
+
+			auto executor = boost::asio::get_associated_executor(
+				*h, m_ioContext.get_executor() );
+
+			return [h, executor]( boost::system::error_code ec,
+					   std::string body ) {
+				boost::asio::post( executor,
+					[h, ec, body = std::move( body )]() mutable {
+						( *h )( ec, std::move( body ) );
+					} );
+			};
+		}
+
+	public:
+		AsyncHttpClient( boost::asio::io_context & ioContext,
+			size_t maxConnectionCount = 4,
+			size_t maxPipelineDepth = 8 );
+
+		~AsyncHttpClient();
+
+		void request( boost::beast::http::verb method,
+			const as::t_string & host,
+			const as::t_string & target,
+			const as::t_string & body,
+			const t_header_list & headers,
+			t_handler handler );
+
+		/// completion signature is void( boost::system::error_code,
+		/// std::string ), works with callbacks, futures and coroutines
+		template <typename CompletionToken>
+		auto asyncGet( const as::t_string & host,
+			const as::t_string & target,
+			CompletionToken && token,
+			const t_header_list & headers = {} )
+		{
+
+			return boost::asio::async_initiate<CompletionToken,
+				void( boost::system::error_code, std::string )>(
+				[this, host, target, headers]( auto handler ) {
+					request( boost::beast::http::verb::get,
+						host,
+						target,
+						{},
+						headers,
+						wrapHandler( std::move( handler ) ) );
+				},
+				token );
+		}
+
+		template <typename CompletionToken>
+		auto asyncPost( const as::t_string & host,
+			const as::t_string & target,
+			const as::t_string & body,
+			CompletionToken && token,
+			const t_header_list & headers = {} )
+		{
+
+			return boost::asio::async_initiate<CompletionToken,
+				void( boost::system::error_code, std::string )>(
+				[this, host, target, body, headers]( auto handler ) {
+					request( boost::beast::http::verb::post,
+						host,
+						target,
+						body,
+						headers,
+						wrapHandler( std::move( handler ) ) );
+				},
+				token );
+		}
+	};
+
+} // namespace as::cryptox::huobi
+
+
+#endif
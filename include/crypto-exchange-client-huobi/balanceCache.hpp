@@ -0,0 +1,121 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// balanceCache.hpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#ifndef __CRYPTO_EXCHANGE_CLIENT_HUOBI__BALANCE_CACHE__H
+#define __CRYPTO_EXCHANGE_CLIENT_HUOBI__BALANCE_CACHE__H
+
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+
+namespace as::cryptox::huobi {
+
+	/// last known balance of every coin, indexed by coin
+	///
+	/// every entry is a seqlock: writers (the ws read handler and the REST
+	/// snapshot completion) take it in turns, readers on any thread never
+	/// block them and retry if an entry changed while being read
+	class BalanceCache {
+	public:
+		static const size_t Capacity = 1024;
+
+		struct t_balance {
+			double balance;
+			double available;
+			// ms, exchange time of the change or of the snapshot request
+			int64_t ts;
+		};
+
+	protected:
+		struct alignas( 64 ) t_entry {
+			// odd while being written
+			std::atomic<uint64_t> seq{ 0 };
+			std::atomic<double> balance{ 0 };
+			std::atomic<double> available{ 0 };
+			std::atomic<int64_t> ts{ 0 };
+		};
+
+	protected:
+		std::unique_ptr<t_entry[]> m_entries;
+
+	protected:
+		void store( size_t index,
+			double balance,
+			double available,
+			int64_t ts,
+			bool isForced );
+
+	public:
+		BalanceCache()
+			: m_entries( new t_entry[Capacity] )
+		{
+		}
+
+		/// a pushed change; NaN keeps the previous value
+		void update(
+			size_t index, double balance, double available, int64_t ts )
+		{
+
+			store( index, balance, available, ts, true );
+		}
+
+		/// a snapshot value; ignored where a newer change has been applied
+		void seed( size_t index, double balance, double available, int64_t ts )
+		{
+			store( index, balance, available, ts, false );
+		}
+
+		/// returns false if nothing is known about the coin
+		bool get( size_t index, t_balance & balance ) const
+		{
+			if ( index >= Capacity ) {
+				return false;
+			}
+
+			const auto & e = m_entries[index];
+			uint64_t seq;
+
+			do {
+				seq = e.seq.load( std::memory_order_acquire );
+
+				balance.balance = e.balance.load( std::memory_order_relaxed );
+				balance.available =
+					e.available.load( std::memory_order_relaxed );
+				balance.ts = e.ts.load( std::memory_order_relaxed );
+
+				std::atomic_thread_fence( std::memory_order_acquire );
+			} while ( ( seq & 1 ) != 0 ||
+				seq != e.seq.load( std::memory_order_relaxed ) );
+
+			return balance.ts != 0;
+		}
+	};
+
+} // namespace as::cryptox::huobi
+
+
+#endif
@@ -0,0 +1,317 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// channel.hpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#ifndef __CRYPTO_EXCHANGE_CLIENT_HUOBI__CHANNEL__H
+#define __CRYPTO_EXCHANGE_CLIENT_HUOBI__CHANNEL__H
+
+
+#include <array>
+#include <string_view>
+#include <cstdint>
+
+
+namespace as::cryptox::huobi {
+
+	/// a topic name, built in place by Channel::topic()
+	class ChannelTopic {
+	public:
+		static const size_t Capacity = 64;
+
+	protected:
+		char m_data[Capacity]{};
+		size_t m_size{ 0 };
+
+	public:
+		constexpr std::string_view View() const
+		{
+			return { m_data, m_size };
+		}
+
+		constexpr bool empty() const
+		{
+			return 0 == m_size;
+		}
+
+		constexpr void clear()
+		{
+			m_size = 0;
+		}
+
+		/// returns false, and leaves the name as it was, if s does not fit
+		constexpr bool append( std::string_view s )
+		{
+			if ( s.size() > Capacity - m_size ) {
+				return false;
+			}
+
+			for ( auto c : s ) {
+				m_data[m_size++] = c;
+			}
+
+			return true;
+		}
+	};
+
+	/// kinds of Huobi channels: builds the topic names to subscribe to and
+	/// classifies the "ch" of incoming messages, both driven by one table
+	///
+	/// a name is the prefix, the symbol if the kind has one, the suffix and
+	/// the parameter if the kind takes one, e.g.
+	/// market.$symbol.depth.step$type, trade.clearing#$symbol#$mode or
+	/// accounts.update#$mode; the symbol and the parameter are single
+	/// tokens, without a '.' or a '#'
+	class Channel {
+	public:
+		static const size_t KindNone = 0;
+		static const size_t KindBbo = 1;
+		static const size_t KindDepth = 2;
+		static const size_t KindMbp = 3;
+		static const size_t KindTrade = 4;
+		static const size_t KindKline = 5;
+		static const size_t KindDetail = 6;
+		static const size_t KindOrders = 7;
+		static const size_t KindTradeClearing = 8;
+		static const size_t KindAccountsUpdate = 9;
+		static const size_t KindCount = 10;
+
+		struct t_kind {
+			std::string_view prefix;
+			std::string_view suffix;
+			bool hasSymbol;
+			bool hasParam;
+		};
+
+		/// a "ch" taken apart, views into it
+		struct t_channel {
+			size_t kind;
+			std::string_view symbol;
+			std::string_view param;
+		};
+
+	protected:
+		// kinds with the same prefix are next to each other and their
+		// suffixes start with the same character, which ends the symbol
+		static constexpr t_kind Kinds[KindCount] = {
+			{ "", "", false, false },
+			{ "market.", ".bbo", true, false },
+			{ "market.", ".depth.step", true, true },
+			{ "market.", ".mbp.", true, true },
+			{ "market.", ".trade.detail", true, false },
+			{ "market.", ".kline.", true, true },
+			{ "market.", ".detail", true, false },
+			{ "orders#", "", true, false },
+			{ "trade.clearing#", "#", true, true },
+			{ "accounts.update#", "", false, true }
+		};
+
+		/// kinds [begin, end) whose prefix starts with a given byte
+		struct t_group {
+			uint8_t begin;
+			uint8_t end;
+		};
+
+		static constexpr std::array<t_group, 256> groups()
+		{
+			std::array<t_group, 256> r{};
+
+			for ( size_t kind = 1; kind < KindCount; kind++ ) {
+				auto & g = r[static_cast<uint8_t>( Kinds[kind].prefix[0] )];
+
+				if ( g.begin == g.end ) {
+					g.begin = static_cast<uint8_t>( kind );
+				}
+
+				g.end = static_cast<uint8_t>( kind + 1 );
+			}
+
+			return r;
+		}
+
+		static const std::array<t_group, 256> Groups;
+
+		static constexpr bool isToken( std::string_view s )
+		{
+			return s.find_first_of( ".#" ) == std::string_view::npos;
+		}
+
+	public:
+		/// the layout the comment of Kinds asks for, checked below
+		static constexpr bool isTableValid()
+		{
+			auto r = groups();
+
+			for ( size_t kind = 1; kind < KindCount; kind++ ) {
+				const auto & k = Kinds[kind];
+				const auto & first =
+					Kinds[r[static_cast<uint8_t>( k.prefix[0] )].begin];
+
+				if ( k.prefix != first.prefix ||
+					k.hasSymbol != first.hasSymbol ||
+					k.suffix.substr( 0, 1 ) != first.suffix.substr( 0, 1 ) ||
+					( !k.hasSymbol && !k.hasParam ) ) {
+
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		static constexpr const t_kind & Kind( size_t kind )
+		{
+			return Kinds[kind];
+		}
+
+		/// an empty name if kind is unknown, symbol or param is missing, not
+		/// expected or not a token, or the name does not fit
+		static constexpr ChannelTopic topic( size_t kind,
+			std::string_view symbol,
+			std::string_view param = {} )
+		{
+
+			ChannelTopic r;
+
+			if ( KindNone == kind || kind >= KindCount ) {
+				return r;
+			}
+
+			const auto & k = Kinds[kind];
+
+			if ( k.hasSymbol == symbol.empty() ||
+				k.hasParam == param.empty() || !isToken( symbol ) ||
+				!isToken( param ) ) {
+
+				return r;
+			}
+
+			if ( !r.append( k.prefix ) || !r.append( symbol ) ||
+				!r.append( k.suffix ) || !r.append( param ) ) {
+
+				r.clear();
+			}
+
+			return r;
+		}
+
+		/// KindNone if ch is none of the known channels; the first byte
+		/// picks the prefix, the rest is a size check per kind sharing it
+		/// and a single comparison for the one which fits
+		static constexpr t_channel classify( std::string_view ch )
+		{
+			t_channel r{ KindNone, {}, {} };
+
+			if ( ch.empty() ) {
+				return r;
+			}
+
+			auto g = Groups[static_cast<uint8_t>( ch[0] )];
+
+			if ( g.begin == g.end ) {
+				return r;
+			}
+
+			const auto & first = Kinds[g.begin];
+
+			if ( ch.substr( 0, first.prefix.size() ) != first.prefix ) {
+				return r;
+			}
+
+			auto rest = ch.substr( first.prefix.size() );
+
+			if ( first.hasSymbol ) {
+				auto end = first.suffix.empty()
+					? rest.size()
+					: ( std::min )( rest.find( first.suffix[0] ), rest.size() );
+
+				if ( 0 == end ) {
+					return r;
+				}
+
+				r.symbol = rest.substr( 0, end );
+				rest = rest.substr( end );
+			}
+
+			for ( size_t kind = g.begin; kind < g.end; kind++ ) {
+				const auto & k = Kinds[kind];
+
+				if ( k.hasParam ? rest.size() <= k.suffix.size()
+								: rest.size() != k.suffix.size() ) {
+
+					continue;
+				}
+
+				if ( rest.substr( 0, k.suffix.size() ) == k.suffix ) {
+					r.param = rest.substr( k.suffix.size() );
+
+					if ( !isToken( r.symbol ) || !isToken( r.param ) ) {
+						break;
+					}
+
+					r.kind = kind;
+
+					return r;
+				}
+			}
+
+			r.param = {};
+			r.symbol = {};
+
+			return r;
+		}
+	};
+
+	constexpr std::array<Channel::t_group, 256> Channel::Groups =
+		Channel::groups();
+
+	static_assert( Channel::isTableValid() );
+
+	static_assert( Channel::topic( Channel::KindAccountsUpdate, {}, "1" )
+					   .View() == "accounts.update#1" );
+
+	static_assert( Channel::classify( "market.btcusdt.trade.detail" ).kind ==
+		Channel::KindTrade );
+
+	static_assert( Channel::classify( "market.btcusdt.detail" ).kind ==
+		Channel::KindDetail );
+
+	static_assert(
+		Channel::classify( "market.btcusdt.depth.step0" ).param == "0" );
+
+	static_assert(
+		Channel::classify( "trade.clearing#btcusdt#1" ).symbol == "btcusdt" );
+
+	static_assert( Channel::classify( "market.btcusdt" ).kind ==
+		Channel::KindNone );
+
+	static_assert( Channel::classify( "market.btcusdt.depth.step0.x" ).kind ==
+		Channel::KindNone );
+
+	static_assert( Channel::classify( "orders#btc.usdt" ).kind ==
+		Channel::KindNone );
+
+} // namespace as::cryptox::huobi
+
+
+#endif
@@ -27,28 +27,233 @@ SOFTWARE.
 #define __CRYPTO_EXCHANGE_CLIENT_HUOBI__CLIENT__H
 
 
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#include "boost/asio.hpp"
+
 #include "crypto-exchange-client-core/httpClient.hpp"
 #include "crypto-exchange-client-core/client.hpp"
 
 #include "crypto-exchange-client-huobi/apiMessage.hpp"
+#include "crypto-exchange-client-huobi/wsMessage.hpp"
+#include "crypto-exchange-client-huobi/feedArbiter.hpp"
+#include "crypto-exchange-client-huobi/asyncHttpClient.hpp"
+#include "crypto-exchange-client-huobi/inflater.hpp"
+#include "crypto-exchange-client-huobi/decodePipeline.hpp"
+#include "crypto-exchange-client-huobi/balanceCache.hpp"
+#include "crypto-exchange-client-huobi/clock.hpp"
+#include "crypto-exchange-client-huobi/rateLimiter.hpp"
+#include "crypto-exchange-client-huobi/shmRing.hpp"
 
 
 namespace as::cryptox::huobi {
 
+	using t_depthHandler =
+		std::function<void( as::cryptox::Client &, size_t, t_depth & )>;
+
+	using t_tradeHandler =
+		std::function<void( as::cryptox::Client &, size_t, t_trade & )>;
+
 	class Client : public as::cryptox::Client {
 	public:
 		static const size_t HttpClientApiIndex = 0;
 		static const size_t WsClientApiIndex = 0;
 		static const size_t WsClientApiFeedIndex = 1;
 		static const size_t WsClientApiV2Index = 2;
+		static const size_t WsClientCount = 3;
+
+		// primary connections first, then standby ones, then feed lines
+		static const size_t WsClientMaxCount = FeedArbiter::MaxLineCount;
+
+		struct t_ws_decode_error_counts {
+			uint64_t inflate;
+			uint64_t parse;
+			uint64_t unknownChannel;
+			uint64_t missingField;
+			uint64_t unknownSymbol;
+			uint64_t errorResponse;
+			uint64_t overflow;
+		};
+
+	protected:
+		struct t_ws_client_state {
+			// steady clock, ms; refreshed by every incoming frame
+			std::atomic<int64_t> lastActivityTs{ 0 };
+			std::atomic<int64_t> reconnectTs{ 0 };
+			std::atomic<bool> isReady{ false };
+			std::atomic<bool> isStarted{ false };
+			// a ping dispatched off the read handler, answered by the next
+			// one; 0 if none
+			std::atomic<int64_t> pendingPingTs{ 0 };
+			// see WsClientUse
+			std::atomic<uint32_t> useCount{ 0 };
+			std::atomic<std::thread::id> swappingThreadId{};
+		};
+
+		/// a use of a connection's slot in the core, by the handlers of the
+		/// connection in it or through callWsClient(); reconnectWsClient()
+		/// swaps the slot only while there is none
+		///
+		/// one which starts while the slot is being swapped, on another
+		/// thread, is turned away, the handlers of the connection being
+		/// replaced have nothing more to do; with isWaiting it waits for the
+		/// new connection instead
+		class WsClientUse {
+		protected:
+			t_ws_client_state & m_state;
+			bool m_isValid;
+
+		public:
+			explicit WsClientUse(
+				t_ws_client_state & state, bool isWaiting = false )
+				: m_state( state )
+			{
+
+				// seq_cst, paired with reconnectWsClient()
+				m_state.useCount.fetch_add( 1 );
+
+				while ( true ) {
+					auto id = m_state.swappingThreadId.load();
+
+					m_isValid = std::thread::id() == id ||
+						std::this_thread::get_id() == id;
+
+					if ( m_isValid || !isWaiting ) {
+						break;
+					}
+
+					std::this_thread::yield();
+				}
+			}
+
+			~WsClientUse()
+			{
+				m_state.useCount.fetch_sub( 1 );
+			}
+
+			WsClientUse( const WsClientUse & ) = delete;
+			WsClientUse & operator=( const WsClientUse & ) = delete;
+
+			bool IsValid() const
+			{
+				return m_isValid;
+			}
+		};
 
 	protected:
 		as::t_string m_apiKey;
 		as::t_string m_apiSecret;
 
+		// pong is written from the connection's read handler only
+		std::array<WsMessageBuffer, WsClientMaxCount> m_wsPongBuffers;
+
+		std::array<t_ws_client_state, WsClientMaxCount> m_wsClientStates;
+		std::array<Inflater, WsClientMaxCount> m_wsInflaters;
+		std::array<WsMessageCache, WsClientMaxCount> m_wsMessageCaches;
+
+		size_t m_wsDecodeThreadCount{ 0 };
+		std::unique_ptr<DecodePipeline> m_decodePipeline;
+
+		std::array<
+			std::array<std::atomic<uint64_t>, WsMessage::DecodeErrorCount>,
+			WsClientMaxCount>
+			m_wsDecodeErrorCounts{};
+		std::array<size_t, WsClientMaxCount> m_wsLogicalIndices{};
+
+		// physical connection currently delivering data for a logical one
+		std::array<std::atomic<size_t>, WsClientCount> m_wsActiveIndices;
+		std::array<bool, WsClientCount> m_isWsClientAnnounced{};
+
+		std::mutex m_wsTopicsSync;
+		std::array<std::vector<as::t_string>, WsClientCount> m_wsTopics;
+
+		bool m_isWsStandbyEnabled{ false };
+
+		std::vector<std::pair<size_t, as::t_string>> m_wsFeedLines;
+		std::array<bool, WsClientCount> m_isWsFeedArbitrated{};
+		FeedArbiter m_feedArbiter;
+
+		// per logical connection, above the interval the server pings at:
+		// 5 s on /ws and /feed, 20 s on /ws/v2
+		std::array<std::chrono::milliseconds, WsClientCount> m_wsStaleTimeouts{
+			std::chrono::milliseconds( 10000 ),
+			std::chrono::milliseconds( 10000 ),
+			std::chrono::milliseconds( 30000 )
+		};
+		std::chrono::milliseconds m_wsReconnectDelay{ 1000 };
+
+		boost::asio::io_context m_serviceIoContext;
+		boost::asio::steady_timer m_wsWatchdogTimer;
+		boost::asio::steady_timer m_clockCalibrationTimer;
+		boost::asio::steady_timer m_clockSyncTimer;
+		std::thread m_serviceThread;
+
+		AsyncHttpClient m_asyncHttpClient;
+		RateLimiter m_rateLimiter;
+
+		Clock m_clock;
+
+		// symbol and coin indices by name, for the lookups which must not
+		// throw; the keys point into m_symbolNames and m_coinNames
+		std::vector<as::t_string> m_symbolNames;
+		std::unordered_map<std::string_view, size_t> m_symbolIndices;
+		std::vector<as::t_string> m_coinNames;
+		std::unordered_map<std::string_view, size_t> m_coinIndices;
+
+		std::map<as::cryptox::Symbol, t_depthHandler> m_depthHandlerMap;
+		std::map<as::cryptox::Symbol, t_tradeHandler> m_tradeHandlerMap;
+
+		as::t_string m_shmRingName;
+		size_t m_shmRingCapacity{ ShmRing::DefaultCapacity };
+		bool m_isShmRingReplacing{ false };
+		std::unique_ptr<ShmRingPublisher> m_shmRingPublisher;
+		// symbols below this are in the ring's symbol table, the rest are
+		// not published
+		size_t m_shmSymbolCount{ 0 };
+		// per record type and symbol
+		std::unique_ptr<std::atomic<uint64_t>[]> m_shmSymbolSeqs;
+
+		std::atomic<int64_t> m_spotAccountId{ 0 };
+		std::atomic<bool> m_isBalanceSubscribed{ false };
+		BalanceCache m_balanceCache;
+
 	private:
 		void addAuthHeaders( HttpHeaderList & headers, as::t_string & body );
 
+		/// path with the signature (v2) query string appended
+		as::t_string signTarget( const as::t_string & path );
+
+		void requestBalanceSnapshot();
+
+		static int64_t steadyTs()
+		{
+			return std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now().time_since_epoch() )
+				.count();
+		}
+
+		void startService();
+		void stopService();
+
+		void armWsWatchdog();
+		void armClockCalibration();
+		void armClockSync();
+		void requestClockSample();
+		void syncClock();
+		/// apiReqCommonTimestamp() without the rate limiter
+		ApiResponseCommonTimestamp getCommonTimestamp();
+		void checkWsClients();
+		void failOverWsClient( size_t index );
+		/// false if the connection is in use, to be tried again later
+		bool reconnectWsClient( size_t index );
+		void onWsClientReady( size_t index );
+
 	protected:
 		void wsErrorHandler(
 			as::WsClient &, int, const as::t_string & ) override;
@@ -56,22 +261,127 @@ namespace as::cryptox::huobi {
 		void wsHandshakeHandler( as::WsClient & ) override;
 		bool wsReadHandler( as::WsClient &, const char *, size_t ) override;
 
-		void initCoinMap() override
+		void initCoinMap() override;
+		void initSymbolMap() override;
+
+		/// fills the symbol map in; symbols get indices in the order they
+		/// are listed, from 1
+		void initPairs( const ApiResponseSettingsCommonSymbols & symbols );
+
+		/// the Coin values keep theirs, every other currency of the symbols
+		/// gets one after them, while BalanceCache::Capacity lasts
+		void initCoinIndices( const ApiResponseSettingsCommonSymbols & symbols );
+
+		void initWsClient( size_t index ) override;
+
+		size_t wsLogicalIndex( size_t index ) const
 		{
-			cryptox::Client::initCoinMap();
+			return m_wsLogicalIndices[index];
+		}
 
-			addCoinMapEntry( AS_T( "btc" ), Coin::BTC );
-			addCoinMapEntry( AS_T( "eth" ), Coin::ETH );
-			addCoinMapEntry( AS_T( "kcs" ), Coin::KCS );
-			addCoinMapEntry( AS_T( "trx" ), Coin::TRX );
-			addCoinMapEntry( AS_T( "usdt" ), Coin::USDT );
+		size_t wsClientCount() const
+		{
+			return ( std::min )( m_wsApiUrls.size(), WsClientMaxCount );
 		}
 
-		void initSymbolMap() override;
-		void initWsClient( size_t index ) override;
+		int64_t wsStaleTimeout( size_t index ) const
+		{
+			return m_wsStaleTimeouts[wsLogicalIndex( index )].count();
+		}
+
+		bool isWsClientActive( size_t index ) const
+		{
+			auto logicalIndex = wsLogicalIndex( index );
+
+			return m_isWsFeedArbitrated[logicalIndex] ||
+				m_wsActiveIndices[logicalIndex].load(
+					std::memory_order_relaxed ) == index;
+		}
+
+		void addWsClient( size_t logicalIndex, const as::Url & url );
+
+		/// 0 for unknown names
+		size_t toSymbolIndex( std::string_view name ) const;
+		size_t toCoinIndex( std::string_view name ) const;
+
+		ApiResponseMarketTickers deserializeMarketTickers(
+			const as::t_string & s );
+
+		void countWsDecodeError( size_t index, size_t error );
 
+		/// what wsReadHandler() does, for a frame of connection
+		/// wsClientIndex, on its thread; client is nullptr if the connection
+		/// is not at hand, a pong is then left to the next call which has it
+		///
+		/// with the decode pipeline, a frame is either decoded here or
+		/// handed to the pipeline, see WsPingMaxSize
+		void handleWsFrame( size_t wsClientIndex,
+			WsClient * client,
+			const char * data,
+			size_t size );
+
+		/// inflates if needed and parses, never throws; see
+		/// WsMessage::deserialize() for cache
+		std::shared_ptr<::as::cryptox::ApiMessageBase> decodeWsFrame(
+			size_t wsClientIndex,
+			Inflater & inflater,
+			WsMessageCache * cache,
+			const char * data,
+			size_t size,
+			size_t & error );
+
+		void writeWsPong( size_t wsClientIndex, WsClient & client, int64_t ts );
+
+		/// what the handlers write to the connection they are called for;
+		/// the gate records it instead
+		virtual void writeWsAsync(
+			WsClient & client, const char * data, size_t size );
+
+		/// client is nullptr when called off the connection's read handler
+		void dispatchWsMessage( size_t wsClientIndex,
+			WsClient * client,
+			::as::cryptox::ApiMessageBase & message );
+
+		/// fill( t_shm_record & ) sets the type specific part
+		template <typename TFill>
+		void publishShm( uint32_t type,
+			as::cryptox::Symbol symbol,
+			int64_t ts,
+			TFill && fill )
+		{
+
+			auto index = static_cast<size_t>( symbol );
+
+			if ( !m_shmRingPublisher || index >= m_shmSymbolCount ) {
+				return;
+			}
+
+			auto symbolSeq =
+				m_shmSymbolSeqs[type * m_pairList.size() + index].fetch_add(
+					1, std::memory_order_relaxed ) +
+				1;
+
+			auto publishTs = m_clock.now();
+
+			m_shmRingPublisher->publish( type,
+				static_cast<uint32_t>( index ),
+				[&]( t_shm_record & r ) {
+					r.symbolSeq = symbolSeq;
+					r.ts = ts;
+					r.publishTs = publishTs;
+					fill( r );
+				} );
+		}
+
+		bool writeTopic( size_t index, const as::t_string & topicName );
 		bool subscribe( size_t wsClientIndex, const as::t_string & topicName );
 
+		/// see Channel::topic(), false if there is no such topic
+		bool subscribeChannel( size_t wsClientIndex,
+			size_t kind,
+			std::string_view symbolName,
+			std::string_view param = {} );
+
 	public:
 		Client( const as::t_string & apiKey = AS_T( "" ),
 			const as::t_string & apiSecret = AS_T( "" ),
@@ -86,11 +396,302 @@ namespace as::cryptox::huobi {
 				  { httpApiUrl }, { wsApiUrl, wsApiFeedUrl, wsApiV2Url } )
 			, m_apiKey( apiKey )
 			, m_apiSecret( apiSecret )
+			, m_wsWatchdogTimer( m_serviceIoContext )
+			, m_clockCalibrationTimer( m_serviceIoContext )
+			, m_clockSyncTimer( m_serviceIoContext )
+			, m_asyncHttpClient( m_serviceIoContext )
+			, m_rateLimiter( m_serviceIoContext )
+		{
+
+			for ( size_t i = 0; i < WsClientCount; i++ ) {
+				m_wsActiveIndices[i] = i;
+				m_wsLogicalIndices[i] = i;
+			}
+		}
+
+		~Client() override;
+
+		/// connection is considered dead if nothing (data or ping) has been
+		/// received for this long; must stay above the interval the server
+		/// pings the connection at
+		Client & WsStaleTimeout(
+			size_t wsClientIndex, std::chrono::milliseconds timeout )
 		{
+
+			m_wsStaleTimeouts[wsClientIndex] = timeout;
+			return *this;
+		}
+
+		/// keeps a second, already authenticated and subscribed, connection
+		/// per endpoint which takes over when the active one goes stale;
+		/// must be set before run()
+		Client & WsStandby( bool isEnabled )
+		{
+			m_isWsStandbyEnabled = isEnabled;
+			return *this;
+		}
+
+		/// inflates and parses frames of the market data connections on
+		/// this many worker threads instead of the read handler; the
+		/// handlers of a connection are still called one at a time, in
+		/// arrival order; frames which find every buffer of the pipeline in
+		/// flight are dropped and counted as overflow; must be set before
+		/// run(), 0 (the default) disables the pipeline
+		Client & WsDecodeThreads( size_t threadCount )
+		{
+			m_wsDecodeThreadCount = threadCount;
+			return *this;
+		}
+
+		/// opens one more connection carrying the same topics as
+		/// wsClientIndex; every update is delivered once, from whichever
+		/// line brings it first, and the handlers of a symbol are still
+		/// called one at a time and in order; must be called before run()
+		///
+		/// lines get indices after the primary and standby connections, in
+		/// the order they were added
+		Client & addWsFeedLine( size_t wsClientIndex, const as::t_string & url )
+		{
+			m_wsFeedLines.emplace_back( wsClientIndex, url );
+			return *this;
+		}
+
+		/// also writes every bbo, depth and trade event received into a
+		/// shared memory ring under this name, for ShmRingSubscriber in
+		/// other processes; capacity is in records, a power of 2; run()
+		/// fails if the name is taken, unless isReplacing; must be set
+		/// before run()
+		///
+		/// symbols past ShmRing::SymbolCapacity are not published
+		Client & ShmPublisher( const as::t_string & name,
+			size_t capacity = ShmRing::DefaultCapacity,
+			bool isReplacing = false )
+		{
+
+			m_shmRingName = name;
+			m_shmRingCapacity = capacity;
+			m_isShmRingReplacing = isReplacing;
+			return *this;
+		}
+
+		/// overrides the documented limit of a RateLimiter::Group*
+		Client & RestRateLimit(
+			size_t group, size_t count, std::chrono::milliseconds period )
+		{
+
+			m_rateLimiter.limit( group, count, period );
+			return *this;
+		}
+
+		/// requests of a RateLimiter::Group* which can be sent right now
+		/// without being queued
+		size_t RestBudget( size_t group ) const
+		{
+			return m_rateLimiter.Remaining( group );
 		}
 
+		/// frames dropped by the connection since start, by reason
+		t_ws_decode_error_counts WsDecodeErrorCounts( size_t index ) const;
+
+		FeedArbiter::t_line_stats WsFeedLineStats( size_t index ) const
+		{
+			return m_feedArbiter.LineStats( index );
+		}
+
+		/// the synchronous calls wait for a token of their rate limiter
+		/// group, ahead of the queued asynchronous ones
 		ApiResponseSettingsCommonSymbols apiReqSettingsCommonSymbols();
 
+		/// completion signature is void( boost::system::error_code,
+		/// TResponse ); completes on the client's service thread, which runs
+		/// while run() does
+		template <typename TResponse,
+			typename TDeserializer,
+			typename CompletionToken>
+		auto apiReqAsync( const as::t_string & target,
+			TDeserializer && deserialize,
+			CompletionToken && token )
+		{
+
+			return boost::asio::async_initiate<CompletionToken,
+				void( boost::system::error_code, TResponse )>(
+				[this, target, deserialize]( auto handler ) {
+					m_asyncHttpClient.asyncGet(
+						m_httpApiUrls[HttpClientApiIndex].Hostname(),
+						target,
+						[handler = std::move( handler ), deserialize](
+							boost::system::error_code ec,
+							std::string body ) mutable {
+							TResponse response;
+
+							if ( !ec ) {
+								try {
+									response = deserialize( body );
+								}
+								catch ( const std::exception & ) {
+									ec = boost::system::errc::make_error_code(
+										boost::system::errc::bad_message );
+								}
+							}
+
+							handler( ec, std::move( response ) );
+						} );
+				},
+				token );
+		}
+
+		template <typename TResponse, typename CompletionToken>
+		auto apiReqAsync(
+			const as::t_string & target, CompletionToken && token )
+		{
+
+
+			return apiReqAsync<TResponse>(
+				target,
+				[]( const std::string & s ) {
+					return TResponse::deserialize( s );
+				},
+				std::forward<CompletionToken>( token ) );
+		}
+
+		/// like apiReqAsync, but waits in the rate limiter queue of the
+		/// group, behind requests of the same or a more urgent priority;
+		/// signed when actually sent, if isSigned
+		///
+		/// completes with resource_unavailable_try_again if the queue is
+		/// full
+		template <typename TResponse,
+			typename TDeserializer,
+			typename CompletionToken>
+		auto apiReqLimitedAsync( size_t group,
+			size_t priority,
+			const as::t_string & path,
+			bool isSigned,
+			TDeserializer && deserialize,
+			CompletionToken && token )
+		{
+
+			return boost::asio::async_initiate<CompletionToken,
+				void( boost::system::error_code, TResponse )>(
+				[this, group, priority, path, isSigned, deserialize](
+					auto handler ) {
+					// jobs are copyable, handlers need not be
+					auto h = std::make_shared<decltype( handler )>(
+						std::move( handler ) );
+
+					bool isQueued = m_rateLimiter.submit( group,
+						priority,
+						[this, h, path, isSigned, deserialize]() {
+							apiReqAsync<TResponse>(
+								isSigned ? signTarget( path ) : path,
+								deserialize,
+								std::move( *h ) );
+						} );
+
+					if ( !isQueued ) {
+						boost::asio::post( m_serviceIoContext, [h]() {
+							( *h )( boost::system::errc::make_error_code(
+										boost::system::errc::
+											resource_unavailable_try_again ),
+								TResponse() );
+						} );
+					}
+				},
+				token );
+		}
+
+		template <typename TResponse, typename CompletionToken>
+		auto apiReqLimitedAsync( size_t group,
+			size_t priority,
+			const as::t_string & path,
+			bool isSigned,
+			CompletionToken && token )
+		{
+
+			return apiReqLimitedAsync<TResponse>(
+				group,
+				priority,
+				path,
+				isSigned,
+				[]( const std::string & s ) {
+					return TResponse::deserialize( s );
+				},
+				std::forward<CompletionToken>( token ) );
+		}
+
+		template <typename CompletionToken>
+		auto apiReqSettingsCommonSymbolsAsync( CompletionToken && token )
+		{
+			return apiReqLimitedAsync<ApiResponseSettingsCommonSymbols>(
+				RateLimiter::GroupCommon,
+				RateLimiter::PriorityMetadata,
+				ApiRequest::SettingsCommonSymbols(),
+				false,
+				std::forward<CompletionToken>( token ) );
+		}
+
+		ApiResponseMarketTickers apiReqMarketTickers();
+
+		template <typename CompletionToken>
+		auto apiReqMarketTickersAsync( CompletionToken && token )
+		{
+			return apiReqLimitedAsync<ApiResponseMarketTickers>(
+				RateLimiter::GroupCommon,
+				RateLimiter::PriorityQuery,
+				ApiRequest::MarketTickers(),
+				false,
+				[this]( const std::string & s ) {
+					return deserializeMarketTickers( s );
+				},
+				std::forward<CompletionToken>( token ) );
+		}
+
+		/// local and estimated server time, all Huobi timestamps the client
+		/// produces come from it
+		const Clock & ClientClock() const
+		{
+			return m_clock;
+		}
+
+		ApiResponseCommonTimestamp apiReqCommonTimestamp();
+
+		template <typename CompletionToken>
+		auto apiReqCommonTimestampAsync( CompletionToken && token )
+		{
+			return apiReqLimitedAsync<ApiResponseCommonTimestamp>(
+				RateLimiter::GroupCommon,
+				RateLimiter::PriorityQuery,
+				ApiRequest::CommonTimestamp(),
+				false,
+				std::forward<CompletionToken>( token ) );
+		}
+
+		ApiResponseAccountAccounts apiReqAccountAccounts();
+
+		template <typename CompletionToken>
+		auto apiReqAccountAccountsAsync( CompletionToken && token )
+		{
+			return apiReqLimitedAsync<ApiResponseAccountAccounts>(
+				RateLimiter::GroupAccount,
+				RateLimiter::PriorityQuery,
+				ApiRequest::AccountAccounts(),
+				true,
+				std::forward<CompletionToken>( token ) );
+		}
+
+		template <typename CompletionToken>
+		auto apiReqAccountBalanceAsync(
+			int64_t accountId, CompletionToken && token )
+		{
+
+			return apiReqLimitedAsync<ApiResponseAccountBalance>(
+				RateLimiter::GroupAccount,
+				RateLimiter::PriorityQuery,
+				ApiRequest::AccountBalance( accountId ),
+				true,
+				std::forward<CompletionToken>( token ) );
+		}
+
 		void run(
 			const t_exchangeClientReadyHandler & handler,
 			const std::function<void( size_t )> & beforeRun = []( size_t ) {
@@ -103,6 +704,44 @@ namespace as::cryptox::huobi {
 		void subscribeOrderUpdate( size_t wsClientIndex,
 			const t_orderUpdateHandler & handler ) override;
 
+		/// market.$symbol.depth.step0, best t_depth::LevelCount levels
+		bool subscribeDepth( size_t wsClientIndex,
+			as::cryptox::Symbol symbol,
+			const t_depthHandler & handler );
+
+		/// market.$symbol.trade.detail, the handler is called per trade
+		bool subscribeTrades( size_t wsClientIndex,
+			as::cryptox::Symbol symbol,
+			const t_tradeHandler & handler );
+
+		/// keeps the spot account balances in memory, read them with
+		/// Balance(); seeded by a REST snapshot, which is repeated after
+		/// every reconnect, and updated by accounts.update#1 pushes
+		///
+		/// wsClientIndex must be WsClientApiV2Index; never blocks, the spot
+		/// account id is looked up through the rate limiter the first time
+		/// and an error is logged if there is none
+		bool subscribeAccountBalance( size_t wsClientIndex );
+
+		/// lock-free, callable from any thread; returns false if nothing is
+		/// known about the coin yet
+		bool Balance( Coin coin, BalanceCache::t_balance & balance ) const
+		{
+			return m_balanceCache.get( static_cast<size_t>( coin ), balance );
+		}
+
+		/// the same for any currency of the listed symbols, by its name
+		/// (e.g. "usdt"), Coin or not; currencies not listed by
+		/// /v2/settings/common/symbols at start are not kept
+		bool Balance( std::string_view currencyName,
+			BalanceCache::t_balance & balance ) const
+		{
+
+			auto coinIndex = toCoinIndex( currencyName );
+
+			return 0 != coinIndex && m_balanceCache.get( coinIndex, balance );
+		}
+
 		t_order placeOrder( Direction direction,
 			as::cryptox::Symbol symbol,
 			const FixedNumber & price,
@@ -0,0 +1,188 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// clock.hpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#ifndef __CRYPTO_EXCHANGE_CLIENT_HUOBI__CLOCK__H
+#define __CRYPTO_EXCHANGE_CLIENT_HUOBI__CLOCK__H
+
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <cstdint>
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+#define AS_HUOBI_CLOCK_TSC
+#if defined( _MSC_VER )
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+
+namespace as::cryptox::huobi {
+
+	/// local time source and server clock offset estimate
+	///
+	/// now() extrapolates the system clock from the TSC (assumed invariant)
+	/// using an anchor and a rate refreshed by calibrate(); elsewhere, and
+	/// until the first calibrate(), it is system_clock::now()
+	///
+	/// the offset comes from round trips (request sent, server time, reply
+	/// received) and from one-way server timestamps such as pings; of the
+	/// last WindowSize samples the one with the shortest round trip wins,
+	/// which filters out the ones delayed by queueing
+	class Clock {
+	public:
+		static const size_t WindowSize = 8;
+
+		// round trips longer than this are not worth keeping
+		static const int64_t MaxRtt = 2000000000;
+
+	protected:
+		struct t_sample {
+			int64_t offset;
+			int64_t rtt;
+		};
+
+	protected:
+		// seqlock over the calibration, odd while being written
+		std::atomic<uint64_t> m_seq{ 0 };
+		std::atomic<uint64_t> m_baseTsc{ 0 };
+		std::atomic<int64_t> m_baseTs{ 0 };
+		std::atomic<double> m_nsPerTick{ 0 };
+
+		uint64_t m_firstTsc{ 0 };
+		int64_t m_firstTs{ 0 };
+
+		std::atomic<int64_t> m_offset{ 0 };
+		std::atomic<int64_t> m_rtt{ 0 };
+
+		std::mutex m_samplesSync;
+		std::array<t_sample, WindowSize> m_samples{};
+		size_t m_sampleCount{ 0 };
+		size_t m_sampleIndex{ 0 };
+		std::array<int64_t, WindowSize> m_lags{};
+		size_t m_lagCount{ 0 };
+		size_t m_lagIndex{ 0 };
+		int64_t m_minRtt{ 0 };
+
+	protected:
+		static int64_t systemTs()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::system_clock::now().time_since_epoch() )
+				.count();
+		}
+
+		static uint64_t tsc()
+		{
+#if defined( AS_HUOBI_CLOCK_TSC )
+			return __rdtsc();
+#else
+			return 0;
+#endif
+		}
+
+		void addSample( int64_t offset, int64_t rtt );
+
+	public:
+		/// takes the first anchor; the rate comes with calibrate()
+		Clock();
+
+		/// re-anchors to the system clock and refines the rate; one thread
+		/// at a time. Client calls it once a second, which keeps now()
+		/// within a few us of the system clock as long as the latter is not
+		/// slewed by more than that per second; the first call should come
+		/// a good while after construction, the rate is only as precise as
+		/// the time between the two
+		void calibrate();
+
+		/// local time, ns since epoch
+		int64_t now() const
+		{
+#if defined( AS_HUOBI_CLOCK_TSC )
+			uint64_t seq;
+			uint64_t baseTsc;
+			int64_t baseTs;
+			double nsPerTick;
+
+			do {
+				seq = m_seq.load( std::memory_order_acquire );
+
+				baseTsc = m_baseTsc.load( std::memory_order_relaxed );
+				baseTs = m_baseTs.load( std::memory_order_relaxed );
+				nsPerTick = m_nsPerTick.load( std::memory_order_relaxed );
+
+				std::atomic_thread_fence( std::memory_order_acquire );
+			} while ( ( seq & 1 ) != 0 ||
+				seq != m_seq.load( std::memory_order_relaxed ) );
+
+			if ( 0 == nsPerTick ) {
+				return systemTs();
+			}
+
+			return baseTs +
+				static_cast<int64_t>(
+					static_cast<double>(
+						static_cast<int64_t>( tsc() - baseTsc ) ) *
+					nsPerTick );
+#else
+			return systemTs();
+#endif
+		}
+
+		/// estimated server time, ms since epoch, as in Huobi timestamps
+		int64_t ServerTs() const
+		{
+			return ( now() + m_offset.load( std::memory_order_relaxed ) ) /
+				1000000;
+		}
+
+		/// server minus local, ns
+		int64_t Offset() const
+		{
+			return m_offset.load( std::memory_order_relaxed );
+		}
+
+		/// round trip of the sample the offset comes from, ns
+		int64_t Rtt() const
+		{
+			return m_rtt.load( std::memory_order_relaxed );
+		}
+
+		/// sendTs and recvTs are now() around a request answered with
+		/// serverTs (ms)
+		void sample( int64_t sendTs, int64_t serverTs, int64_t recvTs );
+
+		/// serverTs (ms) was sent by the server and received at recvTs
+		void sampleOneWay( int64_t serverTs, int64_t recvTs );
+	};
+
+} // namespace as::cryptox::huobi
+
+
+#endif
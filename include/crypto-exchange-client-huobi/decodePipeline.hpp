@@ -0,0 +1,135 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// decodePipeline.hpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#ifndef __CRYPTO_EXCHANGE_CLIENT_HUOBI__DECODE_PIPELINE__H
+#define __CRYPTO_EXCHANGE_CLIENT_HUOBI__DECODE_PIPELINE__H
+
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "crypto-exchange-client-core/apiMessage.hpp"
+
+#include "crypto-exchange-client-huobi/inflater.hpp"
+#include "crypto-exchange-client-huobi/mpmcQueue.hpp"
+
+
+namespace as::cryptox::huobi {
+
+	/// spreads inflating and parsing of ws frames over a pool of worker
+	/// threads
+	///
+	/// the io thread only copies a frame into a pooled buffer; workers
+	/// decode frames in parallel and a sequencer per connection hands them
+	/// over in arrival order, which keeps every symbol in order while the
+	/// connections do not wait for each other; buffers are recycled through
+	/// a lock-free free list
+	class DecodePipeline {
+	public:
+		struct t_frame {
+			size_t wsClientIndex;
+			std::vector<char> data;
+			size_t size;
+			uint64_t seq;
+
+			std::shared_ptr<::as::cryptox::ApiMessageBase> message;
+			size_t error;
+
+			std::atomic<uint32_t> next;
+		};
+
+		/// runs on a worker, fills in message and error
+		using t_decoder = std::function<void( Inflater &, t_frame & )>;
+
+		/// runs on whichever worker completes the next frame of a
+		/// connection in order, never concurrently for one connection
+		using t_deliverer = std::function<void( t_frame & )>;
+
+	protected:
+		static const uint32_t None = UINT32_MAX;
+		static const size_t SpinCount = 4096;
+
+		struct t_sequencer {
+			std::atomic<uint64_t> nextSeq{ 0 };
+			std::unique_ptr<std::atomic<uint32_t>[]> slots;
+			std::atomic<uint64_t> nextDeliverSeq{ 0 };
+			std::atomic_flag isDelivering = ATOMIC_FLAG_INIT;
+		};
+
+	protected:
+		t_decoder m_decoder;
+		t_deliverer m_deliverer;
+
+		size_t m_capacity;
+		std::unique_ptr<t_frame[]> m_frames;
+
+		// tag in the upper half against ABA, frame index in the lower one
+		std::atomic<uint64_t> m_freeHead;
+
+		MpmcQueue<uint32_t> m_queue;
+		std::atomic<int64_t> m_queuedCount{ 0 };
+
+		// by connection
+		size_t m_sequencerCount;
+		std::unique_ptr<t_sequencer[]> m_sequencers;
+
+		std::atomic<bool> m_isRunning{ true };
+		std::atomic<size_t> m_sleeperCount{ 0 };
+		std::mutex m_sleepSync;
+		std::condition_variable m_sleepCondition;
+		std::vector<std::thread> m_workers;
+
+	protected:
+		uint32_t acquireFrame();
+		void releaseFrame( uint32_t index );
+
+		void work();
+		void complete( uint32_t index );
+
+	public:
+		/// capacity is rounded up to a power of 2; frames are submitted for
+		/// connections 0 to connectionCount - 1
+		DecodePipeline( size_t threadCount,
+			size_t connectionCount,
+			size_t capacity,
+			const t_decoder & decoder,
+			const t_deliverer & deliverer );
+
+		~DecodePipeline();
+
+		/// io thread side, never blocks; returns false, dropping the frame,
+		/// if all the buffers are in flight
+		bool submit( size_t wsClientIndex, const char * data, size_t size );
+	};
+
+} // namespace as::cryptox::huobi
+
+
+#endif
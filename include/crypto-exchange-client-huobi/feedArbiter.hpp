@@ -0,0 +1,165 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// feedArbiter.hpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#ifndef __CRYPTO_EXCHANGE_CLIENT_HUOBI__FEED_ARBITER__H
+#define __CRYPTO_EXCHANGE_CLIENT_HUOBI__FEED_ARBITER__H
+
+
+#include <atomic>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+
+namespace as::cryptox::huobi {
+
+	/// picks the first copy of every update arriving over several
+	/// connections (lines) carrying the same topics, and hands a key's
+	/// updates over one at a time and in order, whichever lines they came
+	/// from
+	///
+	/// updates are keyed by stream, symbol and a per-symbol sequence which
+	/// only grows (seqId, version or trade id); anything not newer than
+	/// the last delivered one is a duplicate
+	class FeedArbiter {
+	public:
+		static const size_t StreamPriceBookTicker = 0;
+		static const size_t StreamDepth = 1;
+		static const size_t StreamTrade = 2;
+		static const size_t StreamCount = 3;
+
+		static const size_t MaxLineCount = 8;
+
+		// 1 ms per bucket, the last one collects everything slower
+		static const size_t LatencyBucketCount = 1024;
+
+		/// held while an update is being delivered, so that the handlers
+		/// of a key never run on two lines at once, nor get an update
+		/// after a newer one
+		using t_lock = std::unique_lock<std::mutex>;
+
+		struct t_line_stats {
+			uint64_t count;
+			uint64_t firstCount;
+			int64_t latencyP50;
+			int64_t latencyP99;
+		};
+
+	protected:
+		struct t_line {
+			std::atomic<uint64_t> count{ 0 };
+			std::atomic<uint64_t> firstCount{ 0 };
+			std::array<std::atomic<uint64_t>, LatencyBucketCount> latencies{};
+		};
+
+	protected:
+		size_t m_keyCount{ 0 };
+		// per stream and key, guarded by the key's mutex
+		std::unique_ptr<uint64_t[]> m_lastSeqs;
+		std::unique_ptr<std::mutex[]> m_syncs;
+		std::array<t_line, MaxLineCount> m_lines;
+
+	public:
+		/// must be called before any accept(), keys are symbols
+		void init( size_t keyCount );
+
+		/// counts the copy and locks the key; returns the sequence of the
+		/// last update delivered for it, so that updates carrying several
+		/// sequences, like trade batches, can be filtered item by item
+		uint64_t enter( size_t line,
+			size_t stream,
+			size_t key,
+			int64_t latency,
+			t_lock & lock )
+		{
+
+			auto & l = m_lines[line];
+			l.count.fetch_add( 1, std::memory_order_relaxed );
+
+			size_t bucket = latency < 0 ? 0 : static_cast<size_t>( latency );
+
+			if ( bucket >= LatencyBucketCount ) {
+				bucket = LatencyBucketCount - 1;
+			}
+
+			l.latencies[bucket].fetch_add( 1, std::memory_order_relaxed );
+
+			if ( key >= m_keyCount ) {
+				return 0;
+			}
+
+			lock = t_lock( m_syncs[key] );
+
+			return m_lastSeqs[stream * m_keyCount + key];
+		}
+
+		/// with the key locked by enter(), marks the updates up to seq as
+		/// delivered; before they are, in case delivering throws
+		void advance( size_t line, size_t stream, size_t key, uint64_t seq )
+		{
+			if ( key >= m_keyCount ) {
+				return;
+			}
+
+			auto & last = m_lastSeqs[stream * m_keyCount + key];
+
+			if ( seq > last ) {
+				last = seq;
+				m_lines[line].firstCount.fetch_add(
+					1, std::memory_order_relaxed );
+			}
+		}
+
+		/// returns true if this is the first copy of the update, the key
+		/// is then left locked until lock is released
+		bool accept( size_t line,
+			size_t stream,
+			size_t key,
+			uint64_t seq,
+			int64_t latency,
+			t_lock & lock )
+		{
+
+			if ( seq <= enter( line, stream, key, latency, lock ) ) {
+				if ( lock.owns_lock() ) {
+					lock.unlock();
+				}
+
+				return false;
+			}
+
+			advance( line, stream, key, seq );
+
+			return true;
+		}
+
+		t_line_stats LineStats( size_t line ) const;
+	};
+
+} // namespace as::cryptox::huobi
+
+
+#endif
@@ -0,0 +1,90 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// inflater.hpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#ifndef __CRYPTO_EXCHANGE_CLIENT_HUOBI__INFLATER__H
+#define __CRYPTO_EXCHANGE_CLIENT_HUOBI__INFLATER__H
+
+
+#include <vector>
+
+#include "zlib.h"
+
+#include "crypto-exchange-client-huobi/json.hpp"
+
+
+namespace as::cryptox::huobi {
+
+	/// gzip decompressor reusing its stream state and output buffer between
+	/// messages, so steady-state inflating does not allocate
+	///
+	/// the output is followed by at least Padding spare bytes, so that it
+	/// can be parsed in place by JsonDocument
+	class Inflater {
+	public:
+		static const size_t InitialCapacity = 64 * 1024;
+		static const size_t Padding = JsonDocument::Padding;
+
+	protected:
+		z_stream m_stream;
+		bool m_isInitialized{ false };
+		std::vector<char> m_buffer;
+		size_t m_size{ 0 };
+
+	public:
+		Inflater();
+		~Inflater();
+
+		Inflater( const Inflater & ) = delete;
+		Inflater & operator=( const Inflater & ) = delete;
+
+		/// returns false if the input is not a complete gzip stream; the
+		/// output stays valid until the next call
+		bool inflate( const char * data, size_t size );
+
+		/// the size data inflates to, as its gzip trailer tells without
+		/// inflating, modulo 2^32; SIZE_MAX if data is not gzip
+		static size_t InflatedSize( const char * data, size_t size );
+
+		const char * Data() const
+		{
+			return m_buffer.data();
+		}
+
+		size_t Size() const
+		{
+			return m_size;
+		}
+
+		/// bytes readable at Data()
+		size_t Capacity() const
+		{
+			return m_buffer.size();
+		}
+	};
+
+} // namespace as::cryptox::huobi
+
+
+#endif
@@ -0,0 +1,276 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// json.hpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#ifndef __CRYPTO_EXCHANGE_CLIENT_HUOBI__JSON__H
+#define __CRYPTO_EXCHANGE_CLIENT_HUOBI__JSON__H
+
+
+#include <string_view>
+#include <cstdint>
+
+#if defined( AS_HUOBI_JSON_SIMDJSON )
+#include "simdjson.h"
+#else
+#include "boost/json.hpp"
+#endif
+
+
+namespace as::cryptox::huobi {
+
+	/// handle to a value of a JsonDocument, valid until the document is
+	/// parsed again; nothing here throws, a missing field or a wrong type is
+	/// reported as false
+	///
+	/// with the simdjson (On-Demand) backend the document is read in a
+	/// single pass: looking a field of a parent up again invalidates
+	/// whatever has been taken out of its children, so read the scalars of
+	/// an object first and finish a child before going back to its parent
+	class JsonValue {
+	protected:
+#if defined( AS_HUOBI_JSON_SIMDJSON )
+		simdjson::ondemand::value m_value;
+#else
+		const boost::json::value * m_value{ nullptr };
+#endif
+
+		friend class JsonDocument;
+
+	public:
+		bool field( std::string_view key, JsonValue & value )
+		{
+#if defined( AS_HUOBI_JSON_SIMDJSON )
+			return !m_value.find_field_unordered( key ).get( value.m_value );
+#else
+			auto o = m_value->if_object();
+			value.m_value = nullptr == o ? nullptr : o->if_contains( key );
+
+			return nullptr != value.m_value;
+#endif
+		}
+
+		bool toString( std::string_view & s )
+		{
+#if defined( AS_HUOBI_JSON_SIMDJSON )
+			return !m_value.get_string().get( s );
+#else
+			auto p = m_value->if_string();
+
+			if ( nullptr == p ) {
+				return false;
+			}
+
+			s = std::string_view( p->data(), p->size() );
+
+			return true;
+#endif
+		}
+
+		bool toInt64( int64_t & n )
+		{
+#if defined( AS_HUOBI_JSON_SIMDJSON )
+			if ( !m_value.get_int64().get( n ) ) {
+				return true;
+			}
+
+			uint64_t u;
+
+			if ( m_value.get_uint64().get( u ) ) {
+				return false;
+			}
+
+			n = static_cast<int64_t>( u );
+
+			return true;
+#else
+			if ( auto p = m_value->if_int64() ) {
+				n = *p;
+				return true;
+			}
+
+			if ( auto p = m_value->if_uint64() ) {
+				n = static_cast<int64_t>( *p );
+				return true;
+			}
+
+			return false;
+#endif
+		}
+
+		/// integers are taken too
+		bool toDouble( double & n )
+		{
+#if defined( AS_HUOBI_JSON_SIMDJSON )
+			return !m_value.get_double().get( n );
+#else
+			if ( auto p = m_value->if_double() ) {
+				n = *p;
+				return true;
+			}
+
+			int64_t i;
+
+			if ( toInt64( i ) ) {
+				n = static_cast<double>( i );
+				return true;
+			}
+
+			return false;
+#endif
+		}
+
+		bool isNull()
+		{
+#if defined( AS_HUOBI_JSON_SIMDJSON )
+			bool n;
+
+			return !m_value.is_null().get( n ) && n;
+#else
+			return m_value->is_null();
+#endif
+		}
+
+		/// field() and then to*(), false if either fails
+		bool stringField( std::string_view key, std::string_view & s )
+		{
+			JsonValue f;
+
+			return field( key, f ) && f.toString( s );
+		}
+
+		bool int64Field( std::string_view key, int64_t & n )
+		{
+			JsonValue f;
+
+			return field( key, f ) && f.toInt64( n );
+		}
+
+		bool doubleField( std::string_view key, double & n )
+		{
+			JsonValue f;
+
+			return field( key, f ) && f.toDouble( n );
+		}
+
+		/// f( JsonValue & ) is called for every element of an array and
+		/// returns false to stop early; returns false if this is not an
+		/// array or an element is malformed
+		template <typename F> bool forEach( F && f )
+		{
+#if defined( AS_HUOBI_JSON_SIMDJSON )
+			simdjson::ondemand::array a;
+
+			if ( m_value.get_array().get( a ) ) {
+				return false;
+			}
+
+			for ( auto e : a ) {
+				JsonValue v;
+
+				if ( e.get( v.m_value ) ) {
+					return false;
+				}
+
+				if ( !f( v ) ) {
+					break;
+				}
+			}
+
+			return true;
+#else
+			auto a = m_value->if_array();
+
+			if ( nullptr == a ) {
+				return false;
+			}
+
+			for ( const auto & e : *a ) {
+				JsonValue v;
+				v.m_value = &e;
+
+				if ( !f( v ) ) {
+					break;
+				}
+			}
+
+			return true;
+#endif
+		}
+	};
+
+	/// parses a JSON text, with Boost.JSON or simdjson On-Demand
+	/// (AS_HUOBI_JSON_BACKEND)
+	///
+	/// the simdjson backend keeps its parser per thread, so only one
+	/// document per thread can be in use at a time; it reads the input in
+	/// place if Padding readable bytes follow it and copies it otherwise
+	///
+	/// the Boost.JSON backend allocates out of a per thread arena of
+	/// ArenaSize bytes, which is taken back whenever a document is parsed
+	/// while no other one of the thread is alive
+	class JsonDocument {
+	public:
+		static const size_t Padding = 64;
+		static const size_t ArenaSize = 64 * 1024;
+
+	protected:
+#if defined( AS_HUOBI_JSON_SIMDJSON )
+		simdjson::ondemand::document m_document;
+#else
+		boost::json::value m_document;
+#endif
+		JsonValue m_root;
+
+	public:
+#if defined( AS_HUOBI_JSON_SIMDJSON )
+		JsonDocument() = default;
+#else
+		JsonDocument();
+		~JsonDocument();
+#endif
+
+		JsonDocument( const JsonDocument & ) = delete;
+		JsonDocument & operator=( const JsonDocument & ) = delete;
+
+		/// capacity is the number of bytes which can be read at data, at
+		/// least size; returns false if the text is not an object or an
+		/// array or, with Boost.JSON, is malformed (simdjson finds that out
+		/// only while being read)
+		bool parse( const char * data, size_t size, size_t capacity );
+
+		bool parse( std::string_view s )
+		{
+			return parse( s.data(), s.size(), s.size() );
+		}
+
+		JsonValue & Root()
+		{
+			return m_root;
+		}
+	};
+
+} // namespace as::cryptox::huobi
+
+
+#endif
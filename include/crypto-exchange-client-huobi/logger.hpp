@@ -0,0 +1,358 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// logger.hpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#ifndef __CRYPTO_EXCHANGE_CLIENT_HUOBI__LOGGER__H
+#define __CRYPTO_EXCHANGE_CLIENT_HUOBI__LOGGER__H
+
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+#define AS_HUOBI_LOG_LEVEL_TRACE 0
+#define AS_HUOBI_LOG_LEVEL_INFO 1
+#define AS_HUOBI_LOG_LEVEL_ERROR 2
+#define AS_HUOBI_LOG_LEVEL_NONE 3
+
+// set by cmake, see AS_HUOBI_LOG_LEVEL there
+#ifndef AS_HUOBI_LOG_LEVEL
+#define AS_HUOBI_LOG_LEVEL AS_HUOBI_LOG_LEVEL_INFO
+#endif
+
+#define AS_HUOBI_LOG( level, ... )                                             \
+	::as::cryptox::huobi::Logger::log( level, __VA_ARGS__ )
+
+#if AS_HUOBI_LOG_LEVEL <= AS_HUOBI_LOG_LEVEL_TRACE
+#define AS_HUOBI_LOG_TRACE( ... )                                              \
+	AS_HUOBI_LOG( AS_HUOBI_LOG_LEVEL_TRACE, __VA_ARGS__ )
+#else
+#define AS_HUOBI_LOG_TRACE( ... ) ( (void)0 )
+#endif
+
+#if AS_HUOBI_LOG_LEVEL <= AS_HUOBI_LOG_LEVEL_INFO
+#define AS_HUOBI_LOG_INFO( ... )                                               \
+	AS_HUOBI_LOG( AS_HUOBI_LOG_LEVEL_INFO, __VA_ARGS__ )
+#else
+#define AS_HUOBI_LOG_INFO( ... ) ( (void)0 )
+#endif
+
+#if AS_HUOBI_LOG_LEVEL <= AS_HUOBI_LOG_LEVEL_ERROR
+#define AS_HUOBI_LOG_ERROR( ... )                                              \
+	AS_HUOBI_LOG( AS_HUOBI_LOG_LEVEL_ERROR, __VA_ARGS__ )
+#else
+#define AS_HUOBI_LOG_ERROR( ... ) ( (void)0 )
+#endif
+
+
+namespace as::cryptox::huobi {
+
+	/// asynchronous binary logger
+	///
+	/// the calling thread only copies a fixed-size record into its own
+	/// lock-free ring; formatting and output happen on a background thread
+	///
+	/// format is a string literal with {} placeholders; string literal
+	/// arguments are kept as pointers, any other string (char pointers and
+	/// arrays, strings, string views, LogBytes) is copied, possibly
+	/// truncated, into the record
+	class Logger {
+	public:
+		static const size_t MaxArgCount = 6;
+		static const size_t PayloadCapacity = 192;
+		static const size_t RingCapacity = 1024;
+
+		struct t_bytes {
+			const char * data;
+			size_t size;
+		};
+
+	protected:
+		static const uint8_t ArgInt = 0;
+		static const uint8_t ArgUInt = 1;
+		static const uint8_t ArgDouble = 2;
+		static const uint8_t ArgLiteral = 3;
+		static const uint8_t ArgBytes = 4;
+
+		struct t_arg {
+			uint8_t type;
+
+			union {
+				int64_t i;
+				uint64_t u;
+				double d;
+				const char * s;
+
+				struct {
+					uint16_t offset;
+					uint16_t size;
+					uint32_t originalSize;
+				} bytes;
+			};
+		};
+
+		struct t_record {
+			int64_t ts;
+			const char * format;
+			uint8_t level;
+			uint8_t argCount;
+			uint16_t payloadSize;
+			t_arg args[MaxArgCount];
+			char payload[PayloadCapacity];
+		};
+
+		/// single producer (the owning thread), single consumer (the
+		/// background thread)
+		class Ring {
+		protected:
+			std::array<t_record, RingCapacity> m_records;
+			alignas( 64 ) std::atomic<size_t> m_head{ 0 };
+			alignas( 64 ) std::atomic<size_t> m_tail{ 0 };
+
+		public:
+			std::atomic<uint64_t> dropCount{ 0 };
+			std::atomic<bool> isOwned{ false };
+
+		public:
+			t_record * beginWrite()
+			{
+				auto tail = m_tail.load( std::memory_order_relaxed );
+
+				if ( tail - m_head.load( std::memory_order_acquire ) >=
+					RingCapacity ) {
+
+					return nullptr;
+				}
+
+				return &m_records[tail % RingCapacity];
+			}
+
+			void endWrite()
+			{
+				m_tail.store( m_tail.load( std::memory_order_relaxed ) + 1,
+					std::memory_order_release );
+			}
+
+			const t_record * beginRead()
+			{
+				auto head = m_head.load( std::memory_order_relaxed );
+
+				if ( head == m_tail.load( std::memory_order_acquire ) ) {
+					return nullptr;
+				}
+
+				return &m_records[head % RingCapacity];
+			}
+
+			void endRead()
+			{
+				m_head.store( m_head.load( std::memory_order_relaxed ) + 1,
+					std::memory_order_release );
+			}
+
+			/// records read and written so far
+			size_t ReadCount() const
+			{
+				return m_head.load( std::memory_order_acquire );
+			}
+
+			size_t WriteCount() const
+			{
+				return m_tail.load( std::memory_order_acquire );
+			}
+		};
+
+	protected:
+		std::mutex m_ringsSync;
+		std::vector<std::unique_ptr<Ring>> m_rings;
+
+		std::atomic<bool> m_isRunning{ true };
+		std::atomic<FILE *> m_output{ stderr };
+		std::thread m_thread;
+
+		// the background thread waits here when idle; logging never
+		// notifies, flush() and the destructor do
+		std::mutex m_wakeSync;
+		std::condition_variable m_wakeCondition;
+		std::condition_variable m_drainCondition;
+		bool m_isWakeRequested{ false };
+
+	protected:
+		Logger();
+
+		Ring * acquireRing();
+		static Ring * threadRing();
+
+		void process();
+		size_t drain( std::string & buffer );
+		void format( const t_record & record, std::string & buffer );
+
+		static void setArg( t_record & record, t_arg & arg, t_bytes bytes )
+		{
+			auto size = ( std::min )(
+				bytes.size, PayloadCapacity - record.payloadSize );
+
+			std::memcpy( record.payload + record.payloadSize, bytes.data, size );
+
+			arg.type = ArgBytes;
+			arg.bytes.offset = record.payloadSize;
+			arg.bytes.size = static_cast<uint16_t>( size );
+			arg.bytes.originalSize = static_cast<uint32_t>( bytes.size );
+
+			record.payloadSize += static_cast<uint16_t>( size );
+		}
+
+		template <size_t N>
+		static void setArg( t_record &, t_arg & arg, const char ( &s )[N] )
+		{
+			arg.type = ArgLiteral;
+			arg.s = s;
+		}
+
+		template <size_t N>
+		static void setArg( t_record & record, t_arg & arg, char ( &s )[N] )
+		{
+			auto end = static_cast<const char *>( std::memchr( s, 0, N ) );
+			size_t size = nullptr == end ? N : static_cast<size_t>( end - s );
+
+			setArg( record, arg, t_bytes{ s, size } );
+		}
+
+		/// taken by reference, so that arrays do not decay to it
+		template <typename T>
+		static std::enable_if_t<std::is_same_v<std::remove_const_t<T>, char>>
+		setArg( t_record & record, t_arg & arg, T * const & s )
+		{
+
+			if ( nullptr == s ) {
+				setArg( record, arg, "(null)" );
+				return;
+			}
+
+			setArg( record, arg, t_bytes{ s, std::strlen( s ) } );
+		}
+
+		static void setArg(
+			t_record & record, t_arg & arg, std::string_view s )
+		{
+
+			setArg( record, arg, t_bytes{ s.data(), s.size() } );
+		}
+
+		static void setArg(
+			t_record & record, t_arg & arg, const std::string & s )
+		{
+
+			setArg( record, arg, t_bytes{ s.data(), s.size() } );
+		}
+
+		template <typename T>
+		static std::enable_if_t<std::is_arithmetic_v<T>> setArg(
+			t_record &, t_arg & arg, T v )
+		{
+
+			if constexpr ( std::is_floating_point_v<T> ) {
+				arg.type = ArgDouble;
+				arg.d = v;
+			}
+			else if constexpr ( std::is_signed_v<T> ) {
+				arg.type = ArgInt;
+				arg.i = v;
+			}
+			else {
+				arg.type = ArgUInt;
+				arg.u = v;
+			}
+		}
+
+	public:
+		~Logger();
+
+		static Logger & instance();
+
+		/// nullptr disables the output
+		void Output( FILE * output )
+		{
+			m_output = output;
+		}
+
+		/// records lost because a ring was full
+		uint64_t DropCount();
+
+		/// blocks until everything logged so far is written
+		void flush();
+
+		/// arguments are taken as they are passed, so that a char array
+		/// the caller may still change is told from a string literal
+		template <size_t N, typename... TArgs>
+		static void log(
+			int level, const char ( &format )[N], TArgs &&... args )
+		{
+
+			static_assert( sizeof...( TArgs ) <= MaxArgCount );
+
+			auto ring = threadRing();
+			auto record = ring->beginWrite();
+
+			if ( nullptr == record ) {
+				ring->dropCount.fetch_add( 1, std::memory_order_relaxed );
+				return;
+			}
+
+			record->ts = std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::system_clock::now().time_since_epoch() )
+							 .count();
+
+			record->format = format;
+			record->level = static_cast<uint8_t>( level );
+			record->argCount = static_cast<uint8_t>( sizeof...( TArgs ) );
+			record->payloadSize = 0;
+
+			[[maybe_unused]] size_t i = 0;
+			( setArg( *record, record->args[i++], args ), ... );
+
+			ring->endWrite();
+		}
+	};
+
+	inline Logger::t_bytes LogBytes( const char * data, size_t size )
+	{
+		return { data, size };
+	}
+
+} // namespace as::cryptox::huobi
+
+
+#endif
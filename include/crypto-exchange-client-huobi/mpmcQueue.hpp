@@ -0,0 +1,134 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// mpmcQueue.hpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#ifndef __CRYPTO_EXCHANGE_CLIENT_HUOBI__MPMC_QUEUE__H
+#define __CRYPTO_EXCHANGE_CLIENT_HUOBI__MPMC_QUEUE__H
+
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <cstdint>
+
+
+namespace as::cryptox::huobi {
+
+	/// bounded multi-producer multi-consumer queue (D. Vyukov), capacity
+	/// must be a power of 2
+	template <typename T> class MpmcQueue {
+	protected:
+		struct t_cell {
+			std::atomic<size_t> seq;
+			T value;
+		};
+
+	protected:
+		std::unique_ptr<t_cell[]> m_cells;
+		size_t m_mask;
+		alignas( 64 ) std::atomic<size_t> m_enqueuePos{ 0 };
+		alignas( 64 ) std::atomic<size_t> m_dequeuePos{ 0 };
+
+	public:
+		explicit MpmcQueue( size_t capacity )
+			: m_cells( new t_cell[capacity] )
+			, m_mask( capacity - 1 )
+		{
+
+			for ( size_t i = 0; i < capacity; i++ ) {
+				m_cells[i].seq.store( i, std::memory_order_relaxed );
+			}
+		}
+
+		/// value is left alone if the queue is full
+		bool push( T && value )
+		{
+			auto pos = m_enqueuePos.load( std::memory_order_relaxed );
+
+			while ( true ) {
+				auto & cell = m_cells[pos & m_mask];
+				auto seq = cell.seq.load( std::memory_order_acquire );
+				auto diff = static_cast<intptr_t>( seq ) -
+					static_cast<intptr_t>( pos );
+
+				if ( 0 == diff ) {
+					if ( m_enqueuePos.compare_exchange_weak(
+							 pos, pos + 1, std::memory_order_relaxed ) ) {
+
+						cell.value = std::move( value );
+						cell.seq.store( pos + 1, std::memory_order_release );
+
+						return true;
+					}
+				}
+				else if ( diff < 0 ) {
+					return false;
+				}
+				else {
+					pos = m_enqueuePos.load( std::memory_order_relaxed );
+				}
+			}
+		}
+
+		bool push( const T & value )
+		{
+			T copy( value );
+			return push( std::move( copy ) );
+		}
+
+		bool pop( T & value )
+		{
+			auto pos = m_dequeuePos.load( std::memory_order_relaxed );
+
+			while ( true ) {
+				auto & cell = m_cells[pos & m_mask];
+				auto seq = cell.seq.load( std::memory_order_acquire );
+				auto diff = static_cast<intptr_t>( seq ) -
+					static_cast<intptr_t>( pos + 1 );
+
+				if ( 0 == diff ) {
+					if ( m_dequeuePos.compare_exchange_weak(
+							 pos, pos + 1, std::memory_order_relaxed ) ) {
+
+						value = std::move( cell.value );
+						cell.seq.store(
+							pos + m_mask + 1, std::memory_order_release );
+
+						return true;
+					}
+				}
+				else if ( diff < 0 ) {
+					return false;
+				}
+				else {
+					pos = m_dequeuePos.load( std::memory_order_relaxed );
+				}
+			}
+		}
+	};
+
+} // namespace as::cryptox::huobi
+
+
+#endif
@@ -0,0 +1,150 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// rateLimiter.hpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#ifndef __CRYPTO_EXCHANGE_CLIENT_HUOBI__RATE_LIMITER__H
+#define __CRYPTO_EXCHANGE_CLIENT_HUOBI__RATE_LIMITER__H
+
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <cstdint>
+
+#include "boost/asio.hpp"
+
+#include "crypto-exchange-client-huobi/mpmcQueue.hpp"
+
+
+namespace as::cryptox::huobi {
+
+	/// keeps REST calls within the exchange limits
+	///
+	/// every endpoint group has a token bucket, kept as a single theoretical
+	/// arrival time (GCRA) and taken with one CAS; requests are queued per
+	/// group and priority and released by the io context thread, most urgent
+	/// first, as soon as the bucket allows
+	///
+	/// submitting never blocks and takes no lock while releasing is under
+	/// way (a pass is pending or its timer is armed): it pushes the job and
+	/// leaves it to that pass; only the submit which finds the releasing
+	/// side idle posts a wake-up to the io context
+	class RateLimiter {
+	public:
+		// placing and cancelling orders
+		static const size_t GroupTrade = 0;
+		// accounts, balances and order queries
+		static const size_t GroupAccount = 1;
+		// reference data
+		static const size_t GroupCommon = 2;
+		static const size_t GroupCount = 3;
+
+		static const size_t PriorityCancel = 0;
+		static const size_t PriorityOrder = 1;
+		static const size_t PriorityQuery = 2;
+		static const size_t PriorityMetadata = 3;
+		static const size_t PriorityCount = 4;
+
+		// per group and priority, power of 2
+		static const size_t QueueCapacity = 256;
+
+		typedef std::function<void()> t_job;
+
+	protected:
+		struct t_group {
+			// steady clock, ns
+			alignas( 64 ) std::atomic<int64_t> tat{ 0 };
+			std::atomic<int64_t> interval{ 0 };
+			std::atomic<int64_t> period{ 0 };
+
+			std::atomic<size_t> queuedCount{ 0 };
+			std::array<std::unique_ptr<MpmcQueue<t_job>>, PriorityCount>
+				queues;
+
+			// taken off a queue, waiting for a token; io context thread only
+			t_job next;
+		};
+
+	protected:
+		std::array<t_group, GroupCount> m_groups;
+
+		boost::asio::io_context & m_ioContext;
+		boost::asio::steady_timer m_timer;
+		// a release pass is posted or its timer armed; cleared only by a
+		// pass which finds nothing left to wait for
+		std::atomic<bool> m_isArmed{ false };
+
+	protected:
+		static int64_t steadyTs()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch() )
+				.count();
+		}
+
+		void scheduleRelease();
+		void release();
+
+		/// releases what the buckets allow; returns how long to wait for
+		/// the next token, ns, or -1 if nothing is waiting for one
+		int64_t releaseReady();
+
+		bool isQueueEmpty() const;
+
+	public:
+		/// starts with the documented spot limits
+		explicit RateLimiter( boost::asio::io_context & ioContext );
+
+		/// at most count requests per period; best set before any request
+		void limit(
+			size_t group, size_t count, std::chrono::milliseconds period );
+
+		/// takes a token if there is one; does not look at the queue
+		bool tryAcquire( size_t group );
+
+		/// waits for a token, for synchronous callers; goes ahead of the
+		/// queue
+		void acquire( size_t group );
+
+		/// tokens which can be taken right now
+		size_t Remaining( size_t group ) const;
+
+		/// requests of the group waiting for a token
+		size_t QueuedCount( size_t group ) const
+		{
+			return m_groups[group].queuedCount.load(
+				std::memory_order_relaxed );
+		}
+
+		/// job is run on the io context thread once a token is taken for
+		/// it; returns false, leaving job alone, if the queue is full
+		bool submit( size_t group, size_t priority, t_job && job );
+	};
+
+} // namespace as::cryptox::huobi
+
+
+#endif
@@ -0,0 +1,273 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// shmRing.hpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#ifndef __CRYPTO_EXCHANGE_CLIENT_HUOBI__SHM_RING__H
+#define __CRYPTO_EXCHANGE_CLIENT_HUOBI__SHM_RING__H
+
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+#include "boost/interprocess/shared_memory_object.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
+
+namespace as::cryptox::huobi {
+
+	struct t_shm_level {
+		double price;
+		double size;
+	};
+
+	struct t_shm_price_book_ticker {
+		uint64_t seqId;
+		double askPrice;
+		double askSize;
+		double bidPrice;
+		double bidSize;
+	};
+
+	struct t_shm_depth {
+		static const size_t LevelCount = 20;
+
+		uint64_t version;
+		uint32_t bidCount;
+		uint32_t askCount;
+		t_shm_level bids[LevelCount];
+		t_shm_level asks[LevelCount];
+	};
+
+	struct t_shm_trade {
+		uint64_t tradeId;
+		double price;
+		double amount;
+		uint32_t isBuy;
+	};
+
+	/// one market data event, the same size whatever the type
+	struct t_shm_record {
+		uint32_t type;
+		// index into the ring's symbol table
+		uint32_t symbol;
+		// per type and symbol, from 1; a gap means a lost record
+		uint64_t symbolSeq;
+		// exchange time, ms
+		int64_t ts;
+		// publisher's local time, ns since epoch
+		int64_t publishTs;
+
+		union {
+			t_shm_price_book_ticker priceBookTicker;
+			t_shm_depth depth;
+			t_shm_trade trade;
+		};
+	};
+
+	/// broadcast ring of market data records in named shared memory
+	///
+	/// one or more threads of a single publishing process write, any
+	/// number of processes read; readers never write to the ring, so they
+	/// do not slow the publisher or each other, and once the ring is mapped
+	/// reading takes no syscalls
+	///
+	/// every slot is a seqlock stamped with the record's position in the
+	/// stream: 2 * seq + 1 while being written, 2 * seq + 2 once done; a
+	/// reader which has been lapped sees a newer stamp and skips ahead
+	class ShmRing {
+	public:
+		static const uint32_t RecordTypePriceBookTicker = 0;
+		static const uint32_t RecordTypeDepth = 1;
+		static const uint32_t RecordTypeTrade = 2;
+		static const uint32_t RecordTypeCount = 3;
+
+		static const size_t SymbolCapacity = 4096;
+		static const size_t SymbolNameSize = 32;
+
+		// records, power of 2
+		static const size_t DefaultCapacity = 16384;
+
+	protected:
+		static const uint64_t Magic = 0x48554f4249524e47;
+		static const uint32_t Version = 1;
+
+		struct t_header {
+			std::atomic<uint64_t> magic;
+			uint32_t version;
+			uint32_t recordSize;
+			uint64_t capacity;
+
+			alignas( 64 ) std::atomic<uint64_t> reserveSeq;
+			alignas( 64 ) std::atomic<uint32_t> symbolCount;
+
+			char symbolNames[SymbolCapacity][SymbolNameSize];
+		};
+
+		struct alignas( 64 ) t_slot {
+			std::atomic<uint64_t> stamp;
+			t_shm_record record;
+		};
+
+		static_assert( std::atomic<uint64_t>::is_always_lock_free,
+			"shared atomics must be lock-free" );
+
+	protected:
+		boost::interprocess::mapped_region m_region;
+		t_header * m_header{ nullptr };
+		t_slot * m_slots{ nullptr };
+		uint64_t m_mask{ 0 };
+
+	protected:
+		void map( boost::interprocess::shared_memory_object & shm,
+			boost::interprocess::mode_t mode );
+
+	public:
+		static size_t Size( size_t capacity )
+		{
+			return sizeof( t_header ) + capacity * sizeof( t_slot );
+		}
+
+		size_t Capacity() const
+		{
+			return m_mask + 1;
+		}
+
+		uint32_t SymbolCount() const
+		{
+			return m_header->symbolCount.load( std::memory_order_acquire );
+		}
+
+		/// empty for unknown indices
+		const char * SymbolName( uint32_t symbol ) const
+		{
+			return symbol < SymbolCount() ? m_header->symbolNames[symbol]
+										  : "";
+		}
+	};
+
+	/// creates the ring and removes the name again when destroyed
+	class ShmRingPublisher : public ShmRing {
+	protected:
+		std::string m_name;
+
+	public:
+		/// throws if there is a ring under the name already, unless
+		/// isReplacing; a replaced ring is lost to whoever still uses it, so
+		/// only for one left over by a publisher which has died
+		ShmRingPublisher( const std::string & name,
+			size_t capacity = DefaultCapacity,
+			bool isReplacing = false );
+
+		~ShmRingPublisher();
+
+		ShmRingPublisher( const ShmRingPublisher & ) = delete;
+		ShmRingPublisher & operator=( const ShmRingPublisher & ) = delete;
+
+		/// names longer than SymbolNameSize - 1 are cut; returns false if
+		/// symbol is not below SymbolCapacity
+		bool addSymbol( uint32_t symbol, const char * name );
+
+		/// fill( t_shm_record & ) writes the record in place; type and
+		/// symbol are set already, symbolSeq is up to the caller
+		template <typename TFill>
+		void publish( uint32_t type, uint32_t symbol, TFill && fill )
+		{
+			auto seq =
+				m_header->reserveSeq.fetch_add( 1, std::memory_order_relaxed );
+
+			auto & slot = m_slots[seq & m_mask];
+
+			slot.stamp.store( 2 * seq + 1, std::memory_order_relaxed );
+			std::atomic_thread_fence( std::memory_order_release );
+
+			slot.record.type = type;
+			slot.record.symbol = symbol;
+			fill( slot.record );
+
+			slot.stamp.store( 2 * seq + 2, std::memory_order_release );
+		}
+	};
+
+	class ShmRingSubscriber : public ShmRing {
+	protected:
+		uint64_t m_seq{ 0 };
+		uint64_t m_lostCount{ 0 };
+
+	protected:
+		void skipAhead()
+		{
+			auto seq = m_header->reserveSeq.load( std::memory_order_acquire );
+			// half a lap behind the publisher, out of the way of its writes
+			auto next = seq > Capacity() / 2 ? seq - Capacity() / 2 : 0;
+
+			if ( next > m_seq ) {
+				m_lostCount += next - m_seq;
+				m_seq = next;
+			}
+		}
+
+	public:
+		/// throws if there is no ring under the name or it is incompatible;
+		/// starts with the records published from now on
+		explicit ShmRingSubscriber( const std::string & name );
+
+		/// never blocks; returns false if there is no new record yet
+		bool poll( t_shm_record & record )
+		{
+			while ( true ) {
+				auto & slot = m_slots[m_seq & m_mask];
+				auto stamp = slot.stamp.load( std::memory_order_acquire );
+
+				if ( stamp < 2 * m_seq + 2 ) {
+					return false;
+				}
+
+				if ( stamp == 2 * m_seq + 2 ) {
+					record = slot.record;
+					std::atomic_thread_fence( std::memory_order_acquire );
+
+					if ( slot.stamp.load( std::memory_order_relaxed ) ==
+						stamp ) {
+
+						m_seq++;
+						return true;
+					}
+				}
+
+				skipAhead();
+			}
+		}
+
+		/// records overwritten before this subscriber got to them
+		uint64_t LostCount() const
+		{
+			return m_lostCount;
+		}
+	};
+
+} // namespace as::cryptox::huobi
+
+
+#endif
@@ -27,11 +27,12 @@ SOFTWARE.
 #define __CRYPTO_EXCHANGE_CLIENT_HUOBI__WS_MESSAGE__H
 
 
-#include <sstream>
-#include <iomanip>
-
-// not ctime as we need gmtime_s
-#include <time.h>
+#include <array>
+#include <vector>
+#include <tuple>
+#include <atomic>
+#include <charconv>
+#include <cstring>
 
 #include "boost/json.hpp"
 
@@ -40,10 +41,102 @@ SOFTWARE.
 #include "crypto-exchange-client-core/wsMessage.hpp"
 
 #include "crypto-exchange-client-huobi/apiMessage.hpp"
+#include "crypto-exchange-client-huobi/channel.hpp"
+#include "crypto-exchange-client-huobi/json.hpp"
 
 
 namespace as::cryptox::huobi {
 
+	struct t_depth_level {
+		double price;
+		double size;
+	};
+
+	/// top of a depth.step* snapshot
+	struct t_depth {
+		static const size_t LevelCount = 20;
+
+		as::cryptox::Symbol symbol;
+		int64_t ts;
+		uint64_t version;
+		size_t bidCount;
+		size_t askCount;
+		std::array<t_depth_level, LevelCount> bids;
+		std::array<t_depth_level, LevelCount> asks;
+	};
+
+	struct t_trade {
+		as::cryptox::Symbol symbol;
+		int64_t ts;
+		uint64_t tradeId;
+		double price;
+		double amount;
+		bool isBuy;
+	};
+
+	/// fixed-capacity output buffer for outgoing ws messages
+	class WsMessageBuffer {
+	public:
+		static const size_t Capacity = 256;
+
+	protected:
+		char m_data[Capacity];
+		size_t m_size{ 0 };
+		bool m_isOverflow{ false };
+
+	public:
+		const char * Data() const
+		{
+			return m_data;
+		}
+
+		size_t Size() const
+		{
+			return m_size;
+		}
+
+		bool IsOverflow() const
+		{
+			return m_isOverflow;
+		}
+
+		void clear()
+		{
+			m_size = 0;
+			m_isOverflow = false;
+		}
+
+		void append( const char * s, size_t size )
+		{
+			if ( size > Capacity - m_size ) {
+				m_isOverflow = true;
+				return;
+			}
+
+			std::memcpy( m_data + m_size, s, size );
+			m_size += size;
+		}
+
+		template <size_t N> void append( const char ( &s )[N] )
+		{
+			append( s, N - 1 );
+		}
+
+		void append( uint64_t n )
+		{
+			auto r = std::to_chars( m_data + m_size, m_data + Capacity, n );
+
+			if ( r.ec != std::errc() ) {
+				m_isOverflow = true;
+				return;
+			}
+
+			m_size = r.ptr - m_data;
+		}
+	};
+
+	class WsMessageCache;
+
 	class WsMessage : public ::as::cryptox::WsMessage {
 	public:
 		static const ::as::cryptox::t_api_message_type_id TypeIdPing = 100;
@@ -56,8 +149,28 @@ namespace as::cryptox::huobi {
 		static const ::as::cryptox::t_api_message_type_id TypeIdAuthResponse =
 			103;
 
+		static const ::as::cryptox::t_api_message_type_id
+			TypeIdAccountUpdate = 104;
+
+		static const ::as::cryptox::t_api_message_type_id TypeIdDepth = 105;
+		static const ::as::cryptox::t_api_message_type_id TypeIdTrade = 106;
+
+		static const size_t DecodeErrorNone = 0;
+		static const size_t DecodeErrorInflate = 1;
+		static const size_t DecodeErrorParse = 2;
+		static const size_t DecodeErrorUnknownChannel = 3;
+		static const size_t DecodeErrorMissingField = 4;
+		// a symbol the client does not know, e.g. listed after start
+		static const size_t DecodeErrorUnknownSymbol = 5;
+		// an error response from the server, e.g. to a subscription
+		static const size_t DecodeErrorResponse = 6;
+		// dropped, the decode pipeline had no buffer left
+		static const size_t DecodeErrorOverflow = 7;
+		static const size_t DecodeErrorCount = 8;
+
 	protected:
-		virtual void deserialize( boost::json::value & o ) = 0;
+		/// returns false if a required field is missing or has a wrong type
+		virtual bool deserialize( JsonValue & v ) = 0;
 
 	public:
 		WsMessage( t_api_message_type_id typeId )
@@ -65,59 +178,69 @@ namespace as::cryptox::huobi {
 		{
 		}
 
+		/// never throws; on failure returns the unknown message and sets
+		/// error to one of DecodeError*; capacity is the number of bytes
+		/// readable at data, see JsonDocument::parse()
+		///
+		/// the message is taken from cache if there is one, a new one is
+		/// made otherwise
 		static std::shared_ptr<::as::cryptox::ApiMessageBase> deserialize(
-			const char * data, size_t size, bool isV2 );
-
-		static std::string Pong( uint64_t ts, bool isV2 )
+			const char * data,
+			size_t size,
+			size_t capacity,
+			bool isV2,
+			WsMessageCache * cache,
+			size_t & error );
+
+		static void Pong( WsMessageBuffer & buffer, uint64_t ts, bool isV2 )
 		{
-			boost::json::object o;
+			buffer.clear();
 
 			if ( isV2 ) {
-				o["action"] = "pong";
-				o["data"] = { { "ts", ts } };
+				buffer.append( "{\"action\":\"pong\",\"data\":{\"ts\":" );
+				buffer.append( ts );
+				buffer.append( "}}" );
 			}
 			else {
-				o["pong"] = ts;
+				buffer.append( "{\"pong\":" );
+				buffer.append( ts );
+				buffer.append( "}" );
 			}
-
-			return boost::json::serialize( o );
 		}
 
-		static as::t_string Subscribe(
-			const as::t_string & topicName, bool isV2 )
+		/// returns false if the topic name does not fit into the buffer
+		static bool Subscribe( WsMessageBuffer & buffer,
+			const as::t_stringview & topicName,
+			bool isV2 )
 		{
 
-			boost::json::object o;
+			buffer.clear();
 
 			if ( isV2 ) {
+				buffer.append( "{\"action\":\"sub\",\"ch\":\"" );
+				buffer.append( topicName.data(), topicName.size() );
+				buffer.append( "\"}" );
 			}
 			else {
-				o["sub"] = topicName;
-				o["id"] = AS_TOSTRING( ApiMessage::RequestId() );
+				buffer.append( "{\"sub\":\"" );
+				buffer.append( topicName.data(), topicName.size() );
+				buffer.append( "\",\"id\":\"" );
+				buffer.append( ApiMessage::RequestId() );
+				buffer.append( "\"}" );
 			}
 
-			return boost::json::serialize( o );
+			return !buffer.IsOverflow();
 		}
 
+		/// ts is the server time, ms since epoch
 		static as::t_string Auth( const as::t_string & hostname,
 			const as::t_string & path,
 			const as::t_string & apiKey,
-			const as::t_string & apiSecret )
+			const as::t_string & apiSecret,
+			int64_t ts )
 		{
 
-			auto ts = time( NULL );
-			struct tm tm;
-
-#if defined( _MSC_VER )
-			gmtime_s( &tm, &ts );
-#else
-			gmtime_r( &ts, &tm );
-#endif
-
-			std::stringstream ss;
-			ss << std::put_time( &tm, "%FT%T" );
-
-			auto tsS = ss.str();
+			auto tsS = ApiMessage::Timestamp( ts );
 
 			as::t_string signData = AS_T( "GET\n" ) + hostname + AS_T( '\n' ) +
 				path + AS_T( '\n' ) + AS_T( "accessKey=" ) + apiKey +
@@ -148,7 +271,7 @@ namespace as::cryptox::huobi {
 		uint64_t m_ts{ 0 };
 
 	protected:
-		void deserialize( boost::json::value & o ) override;
+		bool deserialize( JsonValue & v ) override;
 
 	public:
 		WsMessagePing()
@@ -164,19 +287,31 @@ namespace as::cryptox::huobi {
 
 	class WsMessagePingV2 : public WsMessagePing {
 	protected:
-		void deserialize( boost::json::value & o ) override;
+		bool deserialize( JsonValue & v ) override;
 	};
 
 	class WsMessagePriceBookTicker : public WsMessage {
+	public:
+		/// as parsed, for consumers which need no FixedNumber
+		struct t_values {
+			double askPrice;
+			double askSize;
+			double bidPrice;
+			double bidSize;
+		};
+
 	protected:
 		as::t_string m_symbolName;
+		t_values m_values{};
+		uint64_t m_seqId{ 0 };
+		int64_t m_ts{ 0 };
 		::as::FixedNumber m_askPrice;
 		::as::FixedNumber m_askSize;
 		::as::FixedNumber m_bidPrice;
 		::as::FixedNumber m_bidSize;
 
 	protected:
-		void deserialize( boost::json::value & o ) override;
+		bool deserialize( JsonValue & v ) override;
 
 	public:
 		WsMessagePriceBookTicker()
@@ -189,6 +324,21 @@ namespace as::cryptox::huobi {
 			return m_symbolName;
 		}
 
+		uint64_t SeqId() const
+		{
+			return m_seqId;
+		}
+
+		int64_t Ts() const
+		{
+			return m_ts;
+		}
+
+		const t_values & Values() const
+		{
+			return m_values;
+		}
+
 		::as::FixedNumber & AskPrice()
 		{
 			return m_askPrice;
@@ -210,6 +360,67 @@ namespace as::cryptox::huobi {
 		}
 	};
 
+	/// market.$symbol.depth.step*, only the best t_depth::LevelCount levels
+	/// of each side are kept
+	class WsMessageDepth : public WsMessage {
+	protected:
+		as::t_string m_symbolName;
+		t_depth m_depth{};
+
+	protected:
+		bool deserialize( JsonValue & v ) override;
+
+	public:
+		WsMessageDepth()
+			: WsMessage( TypeIdDepth )
+		{
+		}
+
+		const as::t_string & SymbolName() const
+		{
+			return m_symbolName;
+		}
+
+		/// symbol is left for the client to resolve
+		t_depth & Depth()
+		{
+			return m_depth;
+		}
+	};
+
+	/// market.$symbol.trade.detail, one or more trades
+	class WsMessageTrade : public WsMessage {
+	protected:
+		as::t_string m_symbolName;
+		std::vector<t_trade> m_trades;
+		uint64_t m_lastTradeId{ 0 };
+
+	protected:
+		bool deserialize( JsonValue & v ) override;
+
+	public:
+		WsMessageTrade()
+			: WsMessage( TypeIdTrade )
+		{
+		}
+
+		const as::t_string & SymbolName() const
+		{
+			return m_symbolName;
+		}
+
+		/// symbol is left for the client to resolve
+		std::vector<t_trade> & Trades()
+		{
+			return m_trades;
+		}
+
+		uint64_t LastTradeId() const
+		{
+			return m_lastTradeId;
+		}
+	};
+
 	class WsMessageAccountNotifications : public WsMessage {
 	public:
 		struct Notification {};
@@ -217,7 +428,7 @@ namespace as::cryptox::huobi {
 
 	protected:
 	protected:
-		void deserialize( boost::json::value & o ) override;
+		bool deserialize( JsonValue & v ) override;
 
 	public:
 		WsMessageAccountNotifications()
@@ -226,12 +437,56 @@ namespace as::cryptox::huobi {
 		}
 	};
 
+	/// accounts.update#1; balance or available is NaN when not pushed
+	class WsMessageAccountUpdate : public WsMessage {
+	protected:
+		as::t_string m_currencyName;
+		int64_t m_accountId{ 0 };
+		double m_balance;
+		double m_available;
+		int64_t m_changeTime{ 0 };
+
+	protected:
+		bool deserialize( JsonValue & v ) override;
+
+	public:
+		WsMessageAccountUpdate()
+			: WsMessage( TypeIdAccountUpdate )
+		{
+		}
+
+		const as::t_string & CurrencyName() const
+		{
+			return m_currencyName;
+		}
+
+		int64_t AccountId() const
+		{
+			return m_accountId;
+		}
+
+		double Balance() const
+		{
+			return m_balance;
+		}
+
+		double Available() const
+		{
+			return m_available;
+		}
+
+		int64_t ChangeTime() const
+		{
+			return m_changeTime;
+		}
+	};
+
 	class WsMessageAuthResponse : public WsMessage {
 	protected:
 		bool m_isOk;
 
 	protected:
-		void deserialize( boost::json::value & o ) override;
+		bool deserialize( JsonValue & v ) override;
 
 	public:
 		WsMessageAuthResponse()
@@ -246,6 +501,37 @@ namespace as::cryptox::huobi {
 		}
 	};
 
+	/// one message of every type, reused by WsMessage::deserialize() once
+	/// nobody else holds it, so that decoding allocates nothing in the
+	/// steady state; not thread-safe, one per decoding connection
+	class WsMessageCache {
+	protected:
+		std::tuple<std::shared_ptr<WsMessagePing>,
+			std::shared_ptr<WsMessagePingV2>,
+			std::shared_ptr<WsMessagePriceBookTicker>,
+			std::shared_ptr<WsMessageDepth>,
+			std::shared_ptr<WsMessageTrade>,
+			std::shared_ptr<WsMessageAccountUpdate>,
+			std::shared_ptr<WsMessageAuthResponse>>
+			m_messages;
+
+	public:
+		template <typename T> std::shared_ptr<T> get()
+		{
+			auto & m = std::get<std::shared_ptr<T>>( m_messages );
+
+			if ( !m || m.use_count() > 1 ) {
+				m = std::make_shared<T>();
+			}
+			else {
+				// pairs with the release of the last other owner
+				std::atomic_thread_fence( std::memory_order_acquire );
+			}
+
+			return m;
+		}
+	};
+
 } // namespace as::cryptox::huobi
 
 
@@ -0,0 +1,435 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <exception>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "zlib.h"
+
+#include "crypto-exchange-client-huobi/client.hpp"
+
+
+// usage: crypto-exchange-client-huobi-gate frames symbols baseline
+//            [tolerance] [--record]
+//
+// feeds the recorded frames to the read handler of the client, the way they
+// come from the connection, pongs included, and fails if a steady-state
+// message allocates or its median time exceeds the baseline by more than
+// tolerance percent (25 by default); without a baseline for a message kind
+// its latency is not checked, baselines are machine specific
+//
+// --record writes the medians to baseline instead (the huobi-gate-record
+// target writes them into the build directory) and prints the path to copy
+// the file from
+
+static std::atomic<uint64_t> s_allocationCount{ 0 };
+
+static void * allocate( size_t size, size_t alignment )
+{
+	s_allocationCount.fetch_add( 1, std::memory_order_relaxed );
+
+	void * p = nullptr;
+
+	if ( alignment <= alignof( std::max_align_t ) ) {
+		p = std::malloc( 0 == size ? 1 : size );
+	}
+	else {
+		size = ( size + alignment - 1 ) / alignment * alignment;
+		p = std::aligned_alloc( alignment, 0 == size ? alignment : size );
+	}
+
+	if ( nullptr == p ) {
+		throw std::bad_alloc();
+	}
+
+	return p;
+}
+
+void * operator new( size_t size )
+{
+	return allocate( size, 0 );
+}
+
+void * operator new( size_t size, std::align_val_t alignment )
+{
+	return allocate( size, static_cast<size_t>( alignment ) );
+}
+
+void operator delete( void * p ) noexcept
+{
+	std::free( p );
+}
+
+void operator delete( void * p, size_t ) noexcept
+{
+	std::free( p );
+}
+
+void operator delete( void * p, std::align_val_t ) noexcept
+{
+	std::free( p );
+}
+
+void operator delete( void * p, size_t, std::align_val_t ) noexcept
+{
+	std::free( p );
+}
+
+namespace as::cryptox::huobi {
+
+	/// never connects; keeps what is written to it
+	class GateWsClient : public as::WsClient {
+	protected:
+		std::array<char, 256> m_lastWrite;
+		size_t m_lastWriteSize{ 0 };
+		uint64_t m_writeCount{ 0 };
+
+	public:
+		GateWsClient( size_t index, const as::Url & url )
+			: as::WsClient( index, url )
+		{
+		}
+
+		void record( const char * data, size_t size )
+		{
+			m_lastWriteSize = ( std::min )( size, m_lastWrite.size() );
+			std::memcpy( m_lastWrite.data(), data, m_lastWriteSize );
+			m_writeCount++;
+		}
+
+		std::string_view LastWrite() const
+		{
+			return std::string_view( m_lastWrite.data(), m_lastWriteSize );
+		}
+
+		uint64_t WriteCount() const
+		{
+			return m_writeCount;
+		}
+	};
+
+	class GateClient : public Client {
+	protected:
+		GateWsClient m_wsClient{ WsClientApiIndex,
+			as::Url( AS_T( "wss://api.huobi.pro/ws" ) ) };
+
+	protected:
+		void writeWsAsync(
+			WsClient & client, const char * data, size_t size ) override
+		{
+
+			static_cast<GateWsClient &>( client ).record( data, size );
+		}
+
+	public:
+		void load( const ApiResponseSettingsCommonSymbols & symbols )
+		{
+			initCoinMap();
+			as::cryptox::Client::initSymbolMap();
+			initPairs( symbols );
+		}
+
+		void feed( const std::string & frame )
+		{
+			wsReadHandler( m_wsClient, frame.data(), frame.size() );
+		}
+
+		const GateWsClient & Ws() const
+		{
+			return m_wsClient;
+		}
+	};
+
+} // namespace as::cryptox::huobi
+
+static const size_t WarmUpCount = 1000;
+static const size_t RunCount = 20000;
+
+static std::string readFile( const char * path )
+{
+	std::ifstream f( path, std::ios::binary );
+
+	if ( !f ) {
+		throw std::runtime_error( std::string( "can't read " ) + path );
+	}
+
+	std::stringstream ss;
+	ss << f.rdbuf();
+
+	return ss.str();
+}
+
+/// as sent on the market data connections
+static std::string gzip( const std::string & s )
+{
+	z_stream stream;
+	std::memset( &stream, 0, sizeof( stream ) );
+
+	if ( deflateInit2( &stream,
+			 Z_DEFAULT_COMPRESSION,
+			 Z_DEFLATED,
+			 16 + MAX_WBITS,
+			 8,
+			 Z_DEFAULT_STRATEGY ) != Z_OK ) {
+
+		throw std::runtime_error( "deflateInit2" );
+	}
+
+	std::string r( deflateBound( &stream, s.size() ), 0 );
+
+	stream.next_in =
+		reinterpret_cast<Bytef *>( const_cast<char *>( s.data() ) );
+	stream.avail_in = static_cast<uInt>( s.size() );
+	stream.next_out = reinterpret_cast<Bytef *>( r.data() );
+	stream.avail_out = static_cast<uInt>( r.size() );
+
+	auto result = deflate( &stream, Z_FINISH );
+	r.resize( stream.total_out );
+	deflateEnd( &stream );
+
+	if ( Z_STREAM_END != result ) {
+		throw std::runtime_error( "deflate" );
+	}
+
+	return r;
+}
+
+/// "kind frame" lines, # comments
+static std::map<std::string, std::vector<std::string>> readFrames(
+	const char * path )
+{
+
+	std::map<std::string, std::vector<std::string>> r;
+	std::istringstream ss( readFile( path ) );
+	std::string line;
+
+	while ( std::getline( ss, line ) ) {
+		auto space = line.find( ' ' );
+
+		if ( line.empty() || '#' == line[0] || std::string::npos == space ) {
+			continue;
+		}
+
+		r[line.substr( 0, space )].push_back(
+			gzip( line.substr( space + 1 ) ) );
+	}
+
+	return r;
+}
+
+static std::map<std::string, double> readBaseline( const char * path )
+{
+	std::map<std::string, double> r;
+	std::ifstream f( path );
+	std::string kind;
+	double ns;
+
+	while ( f >> kind >> ns ) {
+		r[kind] = ns;
+	}
+
+	return r;
+}
+
+int main( int argc, char ** argv )
+{
+	using namespace as::cryptox::huobi;
+
+	if ( argc < 4 ) {
+		std::cerr << "usage: " << argv[0]
+				  << " frames symbols baseline [tolerance] [--record]"
+				  << std::endl;
+
+		return 2;
+	}
+
+	bool isRecording = false;
+	double tolerance = 25;
+
+	for ( int i = 4; i < argc; i++ ) {
+		if ( std::strcmp( argv[i], "--record" ) == 0 ) {
+			isRecording = true;
+		}
+		else {
+			tolerance = std::atof( argv[i] );
+		}
+	}
+
+	try {
+		auto symbols = ApiResponseSettingsCommonSymbols::deserialize(
+			readFile( argv[2] ) );
+
+		GateClient client;
+		client.load( symbols );
+
+		std::map<std::string, uint64_t> calls;
+
+		for ( const auto & p : symbols.Pairs() ) {
+			auto symbol = client.toSymbol( p.name.c_str() );
+
+			client.subscribePriceBookTicker( Client::WsClientApiIndex,
+				symbol,
+				[&calls]( as::cryptox::Client &,
+					size_t,
+					as::cryptox::t_price_book_ticker & ) { calls["bbo"]++; } );
+
+			client.subscribeDepth( Client::WsClientApiIndex,
+				symbol,
+				[&calls]( as::cryptox::Client &, size_t, t_depth & ) {
+					calls["depth"]++;
+				} );
+
+			client.subscribeTrades( Client::WsClientApiIndex,
+				symbol,
+				[&calls]( as::cryptox::Client &, size_t, t_trade & ) {
+					calls["trade"]++;
+				} );
+		}
+
+		auto frames = readFrames( argv[1] );
+		auto baseline = readBaseline( argv[3] );
+		std::vector<int64_t> times( RunCount );
+		std::map<std::string, double> medians;
+		bool isOk = true;
+		bool isBaselineMissing = false;
+
+		for ( const auto & [kind, kindFrames] : frames ) {
+			// creates the handler map entries and grows the buffers
+			calls[kind] = 0;
+
+			for ( size_t i = 0; i < WarmUpCount; i++ ) {
+				client.feed( kindFrames[i % kindFrames.size()] );
+			}
+
+			auto writeCount = client.Ws().WriteCount();
+			auto allocationCount =
+				s_allocationCount.load( std::memory_order_relaxed );
+
+			for ( size_t i = 0; i < RunCount; i++ ) {
+				auto start = std::chrono::steady_clock::now();
+				client.feed( kindFrames[i % kindFrames.size()] );
+				auto end = std::chrono::steady_clock::now();
+
+				times[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+					end - start )
+							   .count();
+			}
+
+			allocationCount =
+				s_allocationCount.load( std::memory_order_relaxed ) -
+				allocationCount;
+
+			writeCount = client.Ws().WriteCount() - writeCount;
+
+			std::nth_element(
+				times.begin(), times.begin() + RunCount / 2, times.end() );
+
+			double median = static_cast<double>( times[RunCount / 2] );
+			medians[kind] = median;
+
+			std::cout << kind << ": " << median << " ns median, "
+					  << allocationCount << " allocations in " << RunCount
+					  << " messages";
+
+			if ( allocationCount > 0 ) {
+				std::cout << " FAIL";
+				isOk = false;
+			}
+
+			// every ping answered, nothing else written
+			auto expectedWriteCount = "ping" == kind ? RunCount : 0;
+
+			if ( writeCount != expectedWriteCount ||
+				( writeCount > 0 &&
+					client.Ws().LastWrite().find( "\"pong\"" ) ==
+						std::string_view::npos ) ) {
+
+				std::cout << ", " << writeCount << " writes FAIL";
+				isOk = false;
+			}
+
+			auto it = baseline.find( kind );
+
+			if ( isRecording ) {
+				// written below
+			}
+			else if ( it == baseline.end() ) {
+				std::cout << ", no baseline";
+				isBaselineMissing = true;
+			}
+			else {
+				std::cout << ", baseline " << it->second << " ns";
+
+				if ( median > it->second * ( 100 + tolerance ) / 100 ) {
+					std::cout << " FAIL";
+					isOk = false;
+				}
+			}
+
+			std::cout << std::endl;
+		}
+
+		auto errors = client.WsDecodeErrorCounts( Client::WsClientApiIndex );
+
+		if ( errors.inflate + errors.parse + errors.unknownChannel +
+				errors.missingField + errors.unknownSymbol +
+				errors.errorResponse + errors.overflow >
+			0 ) {
+
+			std::cout << "decode errors FAIL" << std::endl;
+			isOk = false;
+		}
+
+		for ( const auto & [kind, count] : calls ) {
+			if ( kind != "ping" && 0 == count ) {
+				std::cout << kind << ": handler not called FAIL" << std::endl;
+				isOk = false;
+			}
+		}
+
+		if ( isRecording ) {
+			std::ofstream f( argv[3] );
+
+			for ( const auto & [kind, median] : medians ) {
+				f << kind << ' ' << median << '\n';
+			}
+
+			if ( !f.flush() ) {
+				throw std::runtime_error( std::string( "can't write " ) +
+					argv[3] );
+			}
+
+			std::cout << "baseline written to "
+					  << std::filesystem::absolute( argv[3] ).string()
+					  << ", copy it to AS_HUOBI_GATE_BASELINE" << std::endl;
+		}
+		else if ( isBaselineMissing ) {
+			std::cout << "latency not checked without a baseline in "
+					  << argv[3]
+					  << "; build huobi-gate-record and copy the file it "
+						 "writes"
+					  << std::endl;
+		}
+
+		return isOk ? 0 : 1;
+	}
+	catch ( const std::exception & x ) {
+		std::cerr << x.what() << std::endl;
+	}
+	catch ( ... ) {
+		std::cerr << "error" << std::endl;
+	}
+
+	return 1;
+}
@@ -0,0 +1,155 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// shmRing.cpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#include "boost/interprocess/exceptions.hpp"
+
+#include "crypto-exchange-client-core/exception.hpp"
+
+#include "crypto-exchange-client-huobi/shmRing.hpp"
+
+
+namespace as::cryptox::huobi {
+
+	void ShmRing::map( boost::interprocess::shared_memory_object & shm,
+		boost::interprocess::mode_t mode )
+	{
+
+		m_region = boost::interprocess::mapped_region( shm, mode );
+
+		auto p = static_cast<char *>( m_region.get_address() );
+		m_header = reinterpret_cast<t_header *>( p );
+		m_slots = reinterpret_cast<t_slot *>( p + sizeof( t_header ) );
+	}
+
+	////
+
+	ShmRingPublisher::ShmRingPublisher(
+		const std::string & name, size_t capacity, bool isReplacing )
+		: m_name( name )
+	{
+
+		if ( 0 == capacity || ( capacity & ( capacity - 1 ) ) != 0 ) {
+			throw ::as::Exception( AS_T( "capacity must be a power of 2" ) );
+		}
+
+		if ( isReplacing ) {
+			boost::interprocess::shared_memory_object::remove( m_name.c_str() );
+		}
+
+		boost::interprocess::shared_memory_object shm;
+
+		try {
+			shm = boost::interprocess::shared_memory_object(
+				boost::interprocess::create_only,
+				m_name.c_str(),
+				boost::interprocess::read_write );
+		}
+		catch ( const boost::interprocess::interprocess_exception & x ) {
+			if ( boost::interprocess::already_exists_error !=
+				x.get_error_code() ) {
+
+				throw;
+			}
+
+			throw ::as::Exception(
+				AS_T( "market data ring exists already" ) );
+		}
+
+		shm.truncate( static_cast<boost::interprocess::offset_t>(
+			Size( capacity ) ) );
+
+		map( shm, boost::interprocess::read_write );
+		m_mask = capacity - 1;
+
+		// fresh pages are zero, which is an empty ring; the magic goes last
+		// so that subscribers never see a half made header
+		m_header->version = Version;
+		m_header->recordSize = sizeof( t_shm_record );
+		m_header->capacity = capacity;
+		m_header->magic.store( Magic, std::memory_order_release );
+	}
+
+	ShmRingPublisher::~ShmRingPublisher()
+	{
+		boost::interprocess::shared_memory_object::remove( m_name.c_str() );
+	}
+
+	bool ShmRingPublisher::addSymbol( uint32_t symbol, const char * name )
+	{
+		if ( symbol >= SymbolCapacity ) {
+			return false;
+		}
+
+		auto & symbolName = m_header->symbolNames[symbol];
+		std::strncpy( symbolName, name, SymbolNameSize - 1 );
+		symbolName[SymbolNameSize - 1] = 0;
+
+		auto count = m_header->symbolCount.load( std::memory_order_relaxed );
+
+		if ( symbol >= count ) {
+			m_header->symbolCount.store(
+				symbol + 1, std::memory_order_release );
+		}
+
+		return true;
+	}
+
+	////
+
+	ShmRingSubscriber::ShmRingSubscriber( const std::string & name )
+	{
+		boost::interprocess::shared_memory_object shm(
+			boost::interprocess::open_only,
+			name.c_str(),
+			boost::interprocess::read_only );
+
+		boost::interprocess::offset_t size = 0;
+
+		if ( !shm.get_size( size ) ||
+			size < static_cast<boost::interprocess::offset_t>(
+					   sizeof( t_header ) ) ) {
+
+			throw ::as::Exception( AS_T( "not a market data ring" ) );
+		}
+
+		map( shm, boost::interprocess::read_only );
+
+		if ( m_header->magic.load( std::memory_order_acquire ) != Magic ||
+			m_header->version != Version ||
+			m_header->recordSize != sizeof( t_shm_record ) ||
+			static_cast<size_t>( size ) < Size( m_header->capacity ) ) {
+
+			throw ::as::Exception( AS_T( "incompatible market data ring" ) );
+		}
+
+		m_mask = m_header->capacity - 1;
+		m_seq = m_header->reserveSeq.load( std::memory_order_acquire );
+	}
+
+} // namespace as::cryptox::huobi
@@ -0,0 +1,393 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// asyncHttpClient.cpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#include <algorithm>
+#include <chrono>
+
+#include "boost/beast/core.hpp"
+#include "boost/beast/ssl.hpp"
+
+#include "crypto-exchange-client-huobi/asyncHttpClient.hpp"
+
+
+namespace as::cryptox::huobi {
+
+	namespace http = boost::beast::http;
+
+	static const std::chrono::seconds RequestTimeout( 30 );
+
+	// servers drop idle keep-alive connections silently, do not reuse them
+	// after this long
+	static const std::chrono::seconds IdleTimeout( 30 );
+
+	class HttpStatusCategory : public boost::system::error_category {
+	public:
+		const char * name() const noexcept override
+		{
+			return "huobi.http";
+		}
+
+		std::string message( int status ) const override
+		{
+			return "http status " + std::to_string( status );
+		}
+	};
+
+	const boost::system::error_category & httpStatusCategory()
+	{
+		static HttpStatusCategory category;
+		return category;
+	}
+
+	////
+
+	class AsyncHttpClient::Connection
+		: public std::enable_shared_from_this<Connection> {
+
+	protected:
+		as::t_string m_host;
+		size_t m_maxPipelineDepth;
+
+		boost::asio::ip::tcp::resolver m_resolver;
+		boost::beast::ssl_stream<boost::beast::tcp_stream> m_stream;
+		boost::beast::flat_buffer m_buffer;
+		http::response<http::string_body> m_response;
+
+		// not written yet
+		std::deque<std::shared_ptr<t_request>> m_pending;
+		// written, waiting for the response, in order
+		std::deque<std::shared_ptr<t_request>> m_inFlight;
+
+		bool m_isConnecting{ false };
+		bool m_isConnected{ false };
+		bool m_isWriting{ false };
+		bool m_isReading{ false };
+		bool m_isClosed{ false };
+
+		std::chrono::steady_clock::time_point m_lastUseTs;
+
+	protected:
+		static void complete( t_request & request,
+			boost::system::error_code ec,
+			std::string body )
+		{
+
+			if ( request.handler ) {
+				auto handler = std::move( request.handler );
+				handler( ec, std::move( body ) );
+			}
+		}
+
+		void connect()
+		{
+			m_isConnecting = true;
+
+			m_resolver.async_resolve( m_host,
+				"443",
+				[self = shared_from_this()]( boost::system::error_code ec,
+					boost::asio::ip::tcp::resolver::results_type results ) {
+					if ( ec ) {
+						return self->fail( ec );
+					}
+
+					auto & layer = boost::beast::get_lowest_layer( self->m_stream );
+					layer.expires_after( RequestTimeout );
+					layer.async_connect( results,
+						[self]( boost::system::error_code ec,
+							const boost::asio::ip::tcp::endpoint & ) {
+							if ( ec ) {
+								return self->fail( ec );
+							}
+
+							self->handshake();
+						} );
+				} );
+		}
+
+		void handshake()
+		{
+			if ( !SSL_set_tlsext_host_name(
+					 m_stream.native_handle(), m_host.c_str() ) ) {
+
+				return fail( boost::system::error_code(
+					static_cast<int>( ::ERR_get_error() ),
+					boost::asio::error::get_ssl_category() ) );
+			}
+
+			m_stream.async_handshake( boost::asio::ssl::stream_base::client,
+				[self = shared_from_this()]( boost::system::error_code ec ) {
+					if ( ec ) {
+						return self->fail( ec );
+					}
+
+					self->m_isConnecting = false;
+					self->m_isConnected = true;
+					self->write();
+				} );
+		}
+
+		void write()
+		{
+			if ( !m_isConnected || m_isWriting || m_pending.empty() ||
+				m_inFlight.size() >= m_maxPipelineDepth ) {
+
+				return;
+			}
+
+			auto request = m_pending.front();
+			m_pending.pop_front();
+			m_inFlight.push_back( request );
+
+			m_isWriting = true;
+			boost::beast::get_lowest_layer( m_stream ).expires_after(
+				RequestTimeout );
+
+			http::async_write( m_stream,
+				request->message,
+				[self = shared_from_this()](
+					boost::system::error_code ec, size_t ) {
+					self->m_isWriting = false;
+
+					if ( ec ) {
+						return self->fail( ec );
+					}
+
+					// next request goes out without waiting for the response
+					self->write();
+					self->read();
+				} );
+		}
+
+		void read()
+		{
+			if ( m_isReading || m_inFlight.empty() ) {
+				return;
+			}
+
+			m_isReading = true;
+			m_response = {};
+
+			http::async_read( m_stream,
+				m_buffer,
+				m_response,
+				[self = shared_from_this()](
+					boost::system::error_code ec, size_t ) {
+					self->m_isReading = false;
+
+					if ( ec ) {
+						return self->fail( ec );
+					}
+
+					auto request = self->m_inFlight.front();
+					self->m_inFlight.pop_front();
+					self->m_lastUseTs = std::chrono::steady_clock::now();
+
+					auto status = self->m_response.result_int();
+					bool isKeepAlive = self->m_response.keep_alive();
+
+					complete( *request,
+						status / 100 == 2
+							? boost::system::error_code()
+							: boost::system::error_code(
+								  static_cast<int>( status ),
+								  httpStatusCategory() ),
+						std::move( self->m_response.body() ) );
+
+					if ( !isKeepAlive ) {
+						return self->fail( boost::asio::error::eof );
+					}
+
+					self->write();
+					self->read();
+				} );
+		}
+
+		void fail( boost::system::error_code ec )
+		{
+			if ( m_isClosed ) {
+				return;
+			}
+
+			m_isClosed = true;
+			m_isConnected = false;
+
+			boost::system::error_code ignored;
+			boost::beast::get_lowest_layer( m_stream ).socket().close( ignored );
+
+			for ( auto & request : m_inFlight ) {
+				complete( *request, ec, {} );
+			}
+
+			for ( auto & request : m_pending ) {
+				complete( *request, ec, {} );
+			}
+
+			m_inFlight.clear();
+			m_pending.clear();
+		}
+
+	public:
+		Connection( boost::asio::io_context & ioContext,
+			boost::asio::ssl::context & sslContext,
+			const as::t_string & host,
+			size_t maxPipelineDepth )
+			: m_host( host )
+			, m_maxPipelineDepth( maxPipelineDepth )
+			, m_resolver( ioContext )
+			, m_stream( ioContext, sslContext )
+			, m_lastUseTs( std::chrono::steady_clock::now() )
+		{
+		}
+
+		size_t Load() const
+		{
+			return m_pending.size() + m_inFlight.size();
+		}
+
+		bool IsUsable() const
+		{
+			return !m_isClosed &&
+				( Load() > 0 ||
+					std::chrono::steady_clock::now() - m_lastUseTs <
+						IdleTimeout );
+		}
+
+		void submit( std::shared_ptr<t_request> request )
+		{
+			m_lastUseTs = std::chrono::steady_clock::now();
+			m_pending.push_back( std::move( request ) );
+
+			if ( !m_isConnected && !m_isConnecting ) {
+				connect();
+			}
+			else {
+				write();
+			}
+		}
+
+		void close()
+		{
+			fail( boost::asio::error::operation_aborted );
+		}
+	};
+
+	////
+
+	AsyncHttpClient::AsyncHttpClient( boost::asio::io_context & ioContext,
+		size_t maxConnectionCount,
+		size_t maxPipelineDepth )
+		: m_ioContext( ioContext )
+		, m_sslContext( boost::asio::ssl::context::tlsv12_client )
+		, m_maxConnectionCount( maxConnectionCount )
+		, m_maxPipelineDepth( maxPipelineDepth )
+	{
+
+		m_sslContext.set_default_verify_paths();
+		m_sslContext.set_verify_mode( boost::asio::ssl::verify_peer );
+	}
+
+	AsyncHttpClient::~AsyncHttpClient()
+	{
+		for ( auto & pool : m_pools ) {
+			for ( auto & connection : pool.second ) {
+				connection->close();
+			}
+		}
+	}
+
+	void AsyncHttpClient::request( http::verb method,
+		const as::t_string & host,
+		const as::t_string & target,
+		const as::t_string & body,
+		const t_header_list & headers,
+		t_handler handler )
+	{
+
+		auto r = std::make_shared<t_request>();
+		r->host = host;
+		r->handler = std::move( handler );
+
+		auto & message = r->message;
+		message.method( method );
+		message.target( target );
+		message.version( 11 );
+		message.keep_alive( true );
+		message.set( http::field::host, host );
+		message.set( http::field::user_agent, "crypto-exchange-client-huobi" );
+
+		for ( const auto & header : headers ) {
+			message.set( header.first, header.second );
+		}
+
+		if ( !body.empty() ) {
+			message.set( http::field::content_type, "application/json" );
+			message.body() = body;
+		}
+
+		message.prepare_payload();
+
+		boost::asio::post( m_ioContext, [this, r]() {
+			enqueue( r );
+		} );
+	}
+
+	void AsyncHttpClient::enqueue( std::shared_ptr<t_request> request )
+	{
+		auto & pool = m_pools[request->host];
+
+		pool.erase( std::remove_if( pool.begin(),
+						pool.end(),
+						[]( const std::shared_ptr<Connection> & c ) {
+							if ( !c->IsUsable() ) {
+								c->close();
+								return true;
+							}
+
+							return false;
+						} ),
+			pool.end() );
+
+		std::shared_ptr<Connection> connection;
+
+		for ( auto & c : pool ) {
+			if ( !connection || c->Load() < connection->Load() ) {
+				connection = c;
+			}
+		}
+
+		// spread over idle connections first, pipeline once all are busy
+		if ( !connection ||
+			( connection->Load() > 0 && pool.size() < m_maxConnectionCount ) ) {
+
+			connection = std::make_shared<Connection>(
+				m_ioContext, m_sslContext, request->host, m_maxPipelineDepth );
+
+			pool.push_back( connection );
+		}
+
+		connection->submit( std::move( request ) );
+	}
+
+} // namespace as::cryptox::huobi
@@ -0,0 +1,71 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// balanceCache.cpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#include <cmath>
+
+#include "crypto-exchange-client-huobi/balanceCache.hpp"
+
+
+namespace as::cryptox::huobi {
+
+	void BalanceCache::store( size_t index,
+		double balance,
+		double available,
+		int64_t ts,
+		bool isForced )
+	{
+
+		if ( index >= Capacity ) {
+			return;
+		}
+
+		auto & e = m_entries[index];
+		auto seq = e.seq.load( std::memory_order_relaxed );
+
+		do {
+			while ( ( seq & 1 ) != 0 ) {
+				seq = e.seq.load( std::memory_order_relaxed );
+			}
+		} while ( !e.seq.compare_exchange_weak(
+			seq, seq + 1, std::memory_order_acquire ) );
+
+		std::atomic_thread_fence( std::memory_order_release );
+
+		if ( isForced || e.ts.load( std::memory_order_relaxed ) < ts ) {
+			if ( !std::isnan( balance ) ) {
+				e.balance.store( balance, std::memory_order_relaxed );
+			}
+
+			if ( !std::isnan( available ) ) {
+				e.available.store( available, std::memory_order_relaxed );
+			}
+
+			e.ts.store( ts, std::memory_order_relaxed );
+		}
+
+		e.seq.store( seq + 2, std::memory_order_release );
+	}
+
+} // namespace as::cryptox::huobi
@@ -24,22 +24,43 @@ SOFTWARE.
 ///
 
 #include <sstream>
+#include <algorithm>
 
 #include "boost/json.hpp"
-#include "boost/iostreams/device/array.hpp"
-#include "boost/iostreams/filtering_stream.hpp"
-#include "boost/iostreams/filter/gzip.hpp"
-#include "boost/iostreams/copy.hpp"
 
-#include "crypto-exchange-client-core/logger.hpp"
 #include "crypto-exchange-client-core/exception.hpp"
 
 #include "crypto-exchange-client-huobi/client.hpp"
 #include "crypto-exchange-client-huobi/wsMessage.hpp"
+#include "crypto-exchange-client-huobi/logger.hpp"
 
 
 namespace as::cryptox::huobi {
 
+	static const std::chrono::milliseconds WsWatchdogPeriod( 100 );
+
+	static const size_t WsDecodePipelineCapacity = 1024;
+
+	// inflated; {"ping":1492420473027} is 22 bytes, nothing else the server
+	// sends on /ws and /feed comes that small
+	static const size_t WsPingMaxSize = 32;
+
+	static const std::chrono::seconds ClockCalibrationPeriod( 1 );
+	static const std::chrono::seconds ClockSyncPeriod( 10 );
+
+	static const std::pair<const as::t_char *, Coin> Coins[] = {
+		{ AS_T( "btc" ), Coin::BTC },
+		{ AS_T( "eth" ), Coin::ETH },
+		{ AS_T( "kcs" ), Coin::KCS },
+		{ AS_T( "trx" ), Coin::TRX },
+		{ AS_T( "usdt" ), Coin::USDT }
+	};
+
+	Client::~Client()
+	{
+		stopService();
+	}
+
 	void Client::addAuthHeaders(
 		HttpHeaderList & headers, ::as::t_string & body )
 	{
@@ -59,101 +80,660 @@ namespace as::cryptox::huobi {
 			AS_T( "application/x-www-form-urlencoded " ) );
 	}
 
+	as::t_string Client::signTarget( const as::t_string & path )
+	{
+		const auto & url = m_httpApiUrls[HttpClientApiIndex];
+
+		// parameters sorted by name
+		as::t_string query = AS_T( "AccessKeyId=" ) + m_apiKey +
+			AS_T( "&SignatureMethod=HmacSHA256" ) +
+			AS_T( "&SignatureVersion=2" ) + AS_T( "&Timestamp=" ) +
+			as::Url::encode( ApiMessage::Timestamp( m_clock.ServerTs() ) );
+
+		as::t_string signData = AS_T( "GET\n" ) + url.Hostname() +
+			AS_T( '\n' ) + path + AS_T( '\n' ) + query;
+
+		auto sign = hmacSha256( m_apiSecret, signData );
+		auto signature = toBase64( { sign.data(), sign.size() } );
+
+		return path + AS_T( '?' ) + query + AS_T( "&Signature=" ) +
+			as::Url::encode( signature );
+	}
+
 	void Client::wsErrorHandler(
 		WsClient & client, int code, const as::t_string & message )
 	{
 
-		AS_LOG_ERROR_LINE(
-			client.Index() << AS_T( ":" ) << code << AS_T( ":" ) << message );
+		AS_HUOBI_LOG_ERROR( "{}:{}:{}", client.Index(), code, message );
+
+		WsClientUse use( m_wsClientStates[client.Index()] );
+
+		if ( !use.IsValid() ) {
+			return;
+		}
+
+		auto & state = m_wsClientStates[client.Index()];
+		state.isReady = false;
+		// the watchdog reconnects it on the next tick
+		state.lastActivityTs = 0;
+
+		failOverWsClient( client.Index() );
 	}
 
 	void Client::wsHandshakeHandler( WsClient & client )
 	{
-		if ( client.Index() == WsClientApiV2Index ) {
+		// not guarded, only a new connection gets here and it writes its
+		// subscriptions through uses which wait for the slot
+
+		m_wsClientStates[client.Index()].lastActivityTs = steadyTs();
+
+		if ( wsLogicalIndex( client.Index() ) == WsClientApiV2Index ) {
 			auto authMessage =
 				WsMessage::Auth( m_wsApiUrls[client.Index()].Hostname(),
 					m_wsApiUrls[client.Index()].Path(),
 					m_apiKey,
-					m_apiSecret );
+					m_apiSecret,
+					m_clock.ServerTs() );
 
-			client.writeAsync( authMessage.c_str(), authMessage.length() );
+			writeWsAsync( client, authMessage.c_str(), authMessage.length() );
 		}
 		else {
-			AS_CALL( m_clientReadyHandler, *this, client.Index() );
+			onWsClientReady( client.Index() );
 		}
 
 		client.readAsync();
 	}
 
+	void Client::onWsClientReady( size_t index )
+	{
+		auto logicalIndex = wsLogicalIndex( index );
+		bool isAnnounce = false;
+
+		std::vector<as::t_string> topics;
+
+		m_wsClientStates[index].isReady = true;
+
+		{
+			std::lock_guard<std::mutex> lock( m_wsTopicsSync );
+
+			if ( !m_isWsClientAnnounced[logicalIndex] ) {
+				m_isWsClientAnnounced[logicalIndex] = true;
+				m_wsActiveIndices[logicalIndex] = index;
+				isAnnounce = true;
+			}
+			else {
+				topics = m_wsTopics[logicalIndex];
+			}
+		}
+
+		// reconnect or standby: replay everything subscribed so far, outside
+		// the lock, see subscribe(); handlers are kept in the maps and need
+		// no replay
+		for ( const auto & topicName : topics ) {
+			writeTopic( index, topicName );
+		}
+
+		if ( isAnnounce ) {
+			AS_CALL( m_clientReadyHandler, *this, logicalIndex );
+		}
+		else if ( WsClientApiV2Index == logicalIndex &&
+			m_isBalanceSubscribed ) {
+
+			// changes pushed while disconnected are lost
+			requestBalanceSnapshot();
+		}
+	}
+
+	void Client::startService()
+	{
+		m_serviceIoContext.restart();
+		armWsWatchdog();
+		armClockCalibration();
+		armClockSync();
+
+		m_serviceThread = std::thread( [this]() {
+			m_serviceIoContext.run();
+		} );
+	}
+
+	void Client::stopService()
+	{
+		m_serviceIoContext.stop();
+
+		if ( m_serviceThread.joinable() ) {
+			m_serviceThread.join();
+		}
+	}
+
+	void Client::armWsWatchdog()
+	{
+		m_wsWatchdogTimer.expires_after( WsWatchdogPeriod );
+		m_wsWatchdogTimer.async_wait(
+			[this]( const boost::system::error_code & ec ) {
+				if ( ec ) {
+					return;
+				}
+
+				checkWsClients();
+				armWsWatchdog();
+			} );
+	}
+
+	void Client::armClockCalibration()
+	{
+		// the first rate is taken over a whole period too, now() is the
+		// system clock until then
+		m_clockCalibrationTimer.expires_after( ClockCalibrationPeriod );
+		m_clockCalibrationTimer.async_wait(
+			[this]( const boost::system::error_code & ec ) {
+				if ( ec ) {
+					return;
+				}
+
+				m_clock.calibrate();
+				armClockCalibration();
+			} );
+	}
+
+	void Client::armClockSync()
+	{
+		m_clockSyncTimer.expires_after( ClockSyncPeriod );
+		m_clockSyncTimer.async_wait(
+			[this]( const boost::system::error_code & ec ) {
+				if ( ec ) {
+					return;
+				}
+
+				requestClockSample();
+				armClockSync();
+			} );
+	}
+
+	void Client::requestClockSample()
+	{
+		// queued like any request of the group, but timed from when it is
+		// sent: the wait for a token is no part of the round trip
+		bool isQueued = m_rateLimiter.submit( RateLimiter::GroupCommon,
+			RateLimiter::PriorityQuery,
+			[this]() {
+				auto sendTs = m_clock.now();
+
+				apiReqAsync<ApiResponseCommonTimestamp>(
+					ApiRequest::CommonTimestamp(),
+					[this, sendTs]( boost::system::error_code ec,
+						ApiResponseCommonTimestamp r ) {
+						if ( ec ) {
+							AS_HUOBI_LOG_ERROR(
+								"clock sync: {}", ec.message() );
+
+							return;
+						}
+
+						m_clock.sample( sendTs, r.Ts(), m_clock.now() );
+					} );
+			} );
+
+		if ( !isQueued ) {
+			AS_HUOBI_LOG_ERROR( "clock sync: rate limiter queue is full" );
+		}
+	}
+
+	void Client::syncClock()
+	{
+		// timed after the token, as above
+		m_rateLimiter.acquire( RateLimiter::GroupCommon );
+
+		auto sendTs = m_clock.now();
+		auto r = getCommonTimestamp();
+		m_clock.sample( sendTs, r.Ts(), m_clock.now() );
+
+		AS_HUOBI_LOG_INFO( "clock offset {} ns, rtt {} ns",
+			m_clock.Offset(),
+			m_clock.Rtt() );
+	}
+
+	void Client::checkWsClients()
+	{
+		auto now = steadyTs();
+		auto count = wsClientCount();
+
+		for ( size_t i = 0; i < count; i++ ) {
+			auto & state = m_wsClientStates[i];
+
+			if ( !state.isStarted ||
+				now - state.lastActivityTs < wsStaleTimeout( i ) ||
+				now - state.reconnectTs < m_wsReconnectDelay.count() ) {
+
+				continue;
+			}
+
+			if ( reconnectWsClient( i ) ) {
+				AS_HUOBI_LOG_ERROR( "{}: stale, reconnecting", i );
+			}
+		}
+	}
+
+	void Client::failOverWsClient( size_t index )
+	{
+		if ( !isWsClientActive( index ) ) {
+			return;
+		}
+
+		auto logicalIndex = wsLogicalIndex( index );
+		auto now = steadyTs();
+		auto count = wsClientCount();
+
+		for ( size_t i = 0; i < count; i++ ) {
+			auto & state = m_wsClientStates[i];
+
+			if ( i != index && wsLogicalIndex( i ) == logicalIndex &&
+				state.isReady &&
+				now - state.lastActivityTs < wsStaleTimeout( i ) ) {
+
+				m_wsActiveIndices[logicalIndex] = i;
+				AS_HUOBI_LOG_INFO( "{}: failed over to {}", index, i );
+
+				return;
+			}
+		}
+	}
+
+	bool Client::reconnectWsClient( size_t index )
+	{
+		auto & state = m_wsClientStates[index];
+
+		// runs on the service thread while the connection's own thread may
+		// still be in one of its handlers, or another one writing to it; the
+		// slot is swapped only when nobody is using it, the watchdog tries
+		// again on its next tick otherwise
+		state.swappingThreadId = std::this_thread::get_id();
+
+		if ( state.useCount != 0 ) {
+			state.swappingThreadId = std::thread::id();
+			return false;
+		}
+
+		state.isReady = false;
+		failOverWsClient( index );
+
+		initWsClient( index );
+
+		state.swappingThreadId = std::thread::id();
+
+		return true;
+	}
+
 	bool Client::wsReadHandler(
 		WsClient & client, const char * data, size_t size )
 	{
 
-		try {
-			std::string dataS;
-
-			// holy shit!!! instead of the plain transport-level deflate they
-			// use gzip...
-			if ( client.Index() == WsClientApiIndex ||
-				client.Index() == WsClientApiFeedIndex ) {
-
-				boost::iostreams::filtering_istream fis;
-				fis.push( boost::iostreams::gzip_decompressor() );
-				fis.push( boost::iostreams::array_source( data, data + size ) );
-
-				std::stringstream ss;
-				boost::iostreams::copy( fis, ss );
-				dataS = ss.str();
-				data = dataS.c_str();
-				size = dataS.length();
+		WsClientUse use( m_wsClientStates[client.Index()] );
+
+		if ( use.IsValid() ) {
+			handleWsFrame( client.Index(), &client, data, size );
+		}
+
+		return true;
+	}
+
+	void Client::handleWsFrame( size_t wsClientIndex,
+		WsClient * client,
+		const char * data,
+		size_t size )
+	{
+
+		auto index = wsLogicalIndex( wsClientIndex );
+		auto & state = m_wsClientStates[wsClientIndex];
+		bool isPipelined = m_decodePipeline && index != WsClientApiV2Index;
+
+		state.lastActivityTs.store( steadyTs(), std::memory_order_relaxed );
+
+		if ( nullptr != client &&
+			state.pendingPingTs.load( std::memory_order_relaxed ) != 0 ) {
+
+			writeWsPong( wsClientIndex,
+				*client,
+				state.pendingPingTs.exchange( 0, std::memory_order_relaxed ) );
+		}
+
+		// classified once, by the size the frame inflates to, which its
+		// gzip trailer tells: pings are decoded and answered here, on the
+		// connection's thread, rather than behind the market data queued in
+		// the pipeline; everything else is decoded by the pipeline only
+		if ( isPipelined &&
+			Inflater::InflatedSize( data, size ) > WsPingMaxSize ) {
+
+			if ( !m_decodePipeline->submit( wsClientIndex, data, size ) ) {
+				countWsDecodeError(
+					wsClientIndex, WsMessage::DecodeErrorOverflow );
 			}
 
-			AS_LOG_TRACE_LINE(
-				client.Index() << ": " << std::string( data, size ) );
+			return;
+		}
+
+		size_t error;
+		auto message = decodeWsFrame( wsClientIndex,
+			m_wsInflaters[wsClientIndex],
+			&m_wsMessageCaches[wsClientIndex],
+			data,
+			size,
+			error );
 
-			auto message = WsMessage::deserialize(
-				data, size, client.Index() == WsClientApiV2Index );
+		if ( WsMessage::DecodeErrorNone != error ) {
+			countWsDecodeError( wsClientIndex, error );
+			return;
+		}
+
+		dispatchWsMessage( wsClientIndex, client, *message );
+	}
+
+	void Client::writeWsPong(
+		size_t wsClientIndex, WsClient & client, int64_t ts )
+	{
+
+		auto & buffer = m_wsPongBuffers[wsClientIndex];
+
+		WsMessage::Pong(
+			buffer, ts, wsLogicalIndex( wsClientIndex ) == WsClientApiV2Index );
+
+		writeWsAsync( client, buffer.Data(), buffer.Size() );
+	}
+
+	void Client::writeWsAsync(
+		WsClient & client, const char * data, size_t size )
+	{
+
+		client.writeAsync( data, size );
+	}
+
+	std::shared_ptr<::as::cryptox::ApiMessageBase> Client::decodeWsFrame(
+		size_t wsClientIndex,
+		Inflater & inflater,
+		WsMessageCache * cache,
+		const char * data,
+		size_t size,
+		size_t & error )
+	{
+
+		auto index = wsLogicalIndex( wsClientIndex );
+		auto capacity = size;
+
+		// holy shit!!! instead of the plain transport-level deflate they
+		// use gzip...
+		if ( index == WsClientApiIndex || index == WsClientApiFeedIndex ) {
+			if ( !inflater.inflate( data, size ) ) {
+				error = WsMessage::DecodeErrorInflate;
+				return nullptr;
+			}
+
+			data = inflater.Data();
+			size = inflater.Size();
+			capacity = inflater.Capacity();
+		}
+
+		AS_HUOBI_LOG_TRACE( "{}: {}", wsClientIndex, LogBytes( data, size ) );
+
+		return WsMessage::deserialize(
+			data, size, capacity, index == WsClientApiV2Index, cache, error );
+	}
+
+	void Client::dispatchWsMessage( size_t wsClientIndex,
+		WsClient * client,
+		::as::cryptox::ApiMessageBase & message )
+	{
 
-			switch ( message->TypeId() ) {
+		auto index = wsLogicalIndex( wsClientIndex );
+
+		// handlers are user code and may still throw
+		try {
+			switch ( message.TypeId() ) {
 				case WsMessage::TypeIdAuthResponse: {
-					auto m =
-						static_cast<WsMessageAuthResponse *>( message.get() );
+					auto & m = static_cast<WsMessageAuthResponse &>( message );
 
-					if ( m->IsOk() ) {
-						AS_CALL( m_clientReadyHandler, *this, client.Index() );
+					if ( m.IsOk() ) {
+						onWsClientReady( wsClientIndex );
 					}
 					else {
-						AS_CALL( m_clientErrorHandler, *this, client.Index() );
+						AS_CALL( m_clientErrorHandler, *this, index );
 					}
 				}
 
 				break;
 
 				case WsMessage::TypeIdPing: {
-					auto m = static_cast<WsMessagePing *>( message.get() );
-					auto s = WsMessage::Pong(
-						m->Ts(), client.Index() == WsClientApiV2Index );
+					auto & m = static_cast<WsMessagePing &>( message );
+
+					if ( WsClientApiV2Index == index ) {
+						m_clock.sampleOneWay( m.Ts(), m_clock.now() );
+					}
 
-					client.writeAsync( s.c_str(), s.length() );
+					if ( nullptr != client ) {
+						writeWsPong( wsClientIndex, *client, m.Ts() );
+					}
+					else {
+						// not on the connection's thread, which must be the
+						// only one writing to it
+						m_wsClientStates[wsClientIndex].pendingPingTs.store(
+							m.Ts(), std::memory_order_relaxed );
+					}
 				}
 
 				break;
 
 				case WsMessage::TypeIdPriceBookTicker: {
-					auto m = static_cast<WsMessagePriceBookTicker *>(
-						message.get() );
+					if ( !isWsClientActive( wsClientIndex ) ) {
+						break;
+					}
+
+					auto & m =
+						static_cast<WsMessagePriceBookTicker &>( message );
+
+					auto symbolIndex = toSymbolIndex( m.SymbolName() );
+
+					if ( 0 == symbolIndex ) {
+						countWsDecodeError(
+							wsClientIndex, WsMessage::DecodeErrorUnknownSymbol );
+
+						break;
+					}
 
 					as::cryptox::t_price_book_ticker t;
-					t.symbol = toSymbol( m->SymbolName().c_str() );
-					t.askPrice = std::move( m->AskPrice() );
-					t.askQuantity = std::move( m->AskSize() );
-					t.bidPrice = std::move( m->BidPrice() );
-					t.bidQuantity = std::move( m->BidSize() );
-
-					callSymbolHandler( t.symbol,
-						m_priceBookTickerHandlerMap,
-						client.Index(),
-						t );
+					t.symbol = static_cast<as::cryptox::Symbol>( symbolIndex );
+
+					FeedArbiter::t_lock lock;
+
+					if ( m_isWsFeedArbitrated[index] &&
+						!m_feedArbiter.accept( wsClientIndex,
+							FeedArbiter::StreamPriceBookTicker,
+							static_cast<size_t>( t.symbol ),
+							m.SeqId(),
+							m_clock.ServerTs() - m.Ts(),
+							lock ) ) {
+
+						break;
+					}
+
+					publishShm( ShmRing::RecordTypePriceBookTicker,
+						t.symbol,
+						m.Ts(),
+						[&m]( t_shm_record & r ) {
+							const auto & v = m.Values();
+
+							r.priceBookTicker = { m.SeqId(),
+								v.askPrice,
+								v.askSize,
+								v.bidPrice,
+								v.bidSize };
+						} );
+
+					t.askPrice = std::move( m.AskPrice() );
+					t.askQuantity = std::move( m.AskSize() );
+					t.bidPrice = std::move( m.BidPrice() );
+					t.bidQuantity = std::move( m.BidSize() );
+
+					callSymbolHandler(
+						t.symbol, m_priceBookTickerHandlerMap, index, t );
+				}
+
+				break;
+
+				case WsMessage::TypeIdDepth: {
+					if ( !isWsClientActive( wsClientIndex ) ) {
+						break;
+					}
+
+					auto & m = static_cast<WsMessageDepth &>( message );
+					auto symbolIndex = toSymbolIndex( m.SymbolName() );
+
+					if ( 0 == symbolIndex ) {
+						countWsDecodeError(
+							wsClientIndex, WsMessage::DecodeErrorUnknownSymbol );
+
+						break;
+					}
+
+					auto & d = m.Depth();
+					d.symbol = static_cast<as::cryptox::Symbol>( symbolIndex );
+
+					FeedArbiter::t_lock lock;
+
+					if ( m_isWsFeedArbitrated[index] &&
+						!m_feedArbiter.accept( wsClientIndex,
+							FeedArbiter::StreamDepth,
+							static_cast<size_t>( d.symbol ),
+							d.version,
+							m_clock.ServerTs() - d.ts,
+							lock ) ) {
+
+						break;
+					}
+
+					publishShm( ShmRing::RecordTypeDepth,
+						d.symbol,
+						d.ts,
+						[&d]( t_shm_record & r ) {
+							static_assert( t_shm_depth::LevelCount ==
+								t_depth::LevelCount );
+
+							r.depth.version = d.version;
+							r.depth.bidCount =
+								static_cast<uint32_t>( d.bidCount );
+							r.depth.askCount =
+								static_cast<uint32_t>( d.askCount );
+
+							for ( size_t i = 0; i < d.bidCount; i++ ) {
+								r.depth.bids[i] = { d.bids[i].price,
+									d.bids[i].size };
+							}
+
+							for ( size_t i = 0; i < d.askCount; i++ ) {
+								r.depth.asks[i] = { d.asks[i].price,
+									d.asks[i].size };
+							}
+						} );
+
+					auto it = m_depthHandlerMap.find( d.symbol );
+
+					if ( it != m_depthHandlerMap.end() ) {
+						AS_CALL( it->second, *this, index, d );
+					}
+				}
+
+				break;
+
+				case WsMessage::TypeIdTrade: {
+					if ( !isWsClientActive( wsClientIndex ) ) {
+						break;
+					}
+
+					auto & m = static_cast<WsMessageTrade &>( message );
+					auto & trades = m.Trades();
+					auto symbolIndex = toSymbolIndex( m.SymbolName() );
+
+					if ( 0 == symbolIndex ) {
+						countWsDecodeError(
+							wsClientIndex, WsMessage::DecodeErrorUnknownSymbol );
+
+						break;
+					}
+
+					if ( trades.empty() ) {
+						break;
+					}
+
+					auto symbol =
+						static_cast<as::cryptox::Symbol>( symbolIndex );
+
+					FeedArbiter::t_lock lock;
+					uint64_t lastTradeId = 0;
+
+					// lines may batch the same trades differently, each one
+					// is a duplicate or not by its own id
+					if ( m_isWsFeedArbitrated[index] ) {
+						lastTradeId = m_feedArbiter.enter( wsClientIndex,
+							FeedArbiter::StreamTrade,
+							static_cast<size_t>( symbol ),
+							m_clock.ServerTs() - trades.back().ts,
+							lock );
+
+						m_feedArbiter.advance( wsClientIndex,
+							FeedArbiter::StreamTrade,
+							static_cast<size_t>( symbol ),
+							m.LastTradeId() );
+					}
+
+					auto it = m_tradeHandlerMap.find( symbol );
+
+					for ( auto & t : trades ) {
+						if ( t.tradeId <= lastTradeId ) {
+							continue;
+						}
+
+						t.symbol = symbol;
+
+						publishShm( ShmRing::RecordTypeTrade,
+							symbol,
+							t.ts,
+							[&t]( t_shm_record & r ) {
+								r.trade = { t.tradeId,
+									t.price,
+									t.amount,
+									t.isBuy ? 1U : 0U };
+							} );
+
+						if ( it != m_tradeHandlerMap.end() ) {
+							AS_CALL( it->second, *this, index, t );
+						}
+					}
+				}
+
+				break;
+
+				case WsMessage::TypeIdAccountUpdate: {
+					auto & m = static_cast<WsMessageAccountUpdate &>( message );
+
+					if ( !isWsClientActive( wsClientIndex ) ||
+						m.AccountId() != m_spotAccountId ) {
+
+						break;
+					}
+
+					// slot 0 is Coin::_undef, not a place for every coin the
+					// client does not know
+					auto coinIndex = toCoinIndex( m.CurrencyName() );
+
+					if ( 0 == coinIndex ) {
+						break;
+					}
+
+					auto ts = m.ChangeTime();
+
+					if ( 0 == ts ) {
+						ts = m_clock.ServerTs();
+					}
+
+					m_balanceCache.update(
+						coinIndex, m.Balance(), m.Available(), ts );
 				}
 
 				break;
@@ -172,30 +752,69 @@ namespace as::cryptox::huobi {
 			}
 		}
 		catch ( const std::exception & x ) {
-			AS_LOG_ERROR_LINE( x.what() );
+			AS_HUOBI_LOG_ERROR( "{}", std::string_view( x.what() ) );
 		}
 		catch ( ... ) {
 		}
+	}
 
-		return true;
+	void Client::initCoinMap()
+	{
+		cryptox::Client::initCoinMap();
+
+		for ( const auto & c : Coins ) {
+			addCoinMapEntry( c.first, c.second );
+		}
 	}
 
 	void Client::initSymbolMap()
 	{
-		AS_LOG_INFO_LINE( "initializing..." );
+		AS_HUOBI_LOG_INFO( "initializing..." );
 
 		as::cryptox::Client::initSymbolMap();
 
-		auto apiRes = apiReqSettingsCommonSymbols();
-		m_pairList.resize( apiRes.Pairs().size() + 2 );
+		// before anything gets signed
+		syncClock();
+
+		initPairs( apiReqSettingsCommonSymbols() );
+
+		AS_HUOBI_LOG_INFO( "done" );
+	}
+
+	void Client::initPairs( const ApiResponseSettingsCommonSymbols & symbols )
+	{
+		m_pairList.resize( symbols.Pairs().size() + 2 );
+		m_feedArbiter.init( m_pairList.size() );
+
+		if ( !m_shmRingName.empty() ) {
+			m_shmRingPublisher = std::make_unique<ShmRingPublisher>(
+				m_shmRingName, m_shmRingCapacity, m_isShmRingReplacing );
+
+			// 0 is undefined, never published
+			m_shmSymbolCount = 1;
+
+			auto count = ShmRing::RecordTypeCount * m_pairList.size();
+			m_shmSymbolSeqs.reset( new std::atomic<uint64_t>[count] );
+
+			for ( size_t i = 0; i < count; i++ ) {
+				m_shmSymbolSeqs[i] = 0;
+			}
+		}
+
 		m_pairList[0] = as::cryptox::Pair( as::cryptox::Coin::_undef,
 			as::cryptox::Coin::_undef,
 			AS_T( "undefined" ) );
 
+		initCoinIndices( symbols );
+
+		// sized once, so that the keys of m_symbolIndices stay valid
+		m_symbolNames.assign( m_pairList.size(), as::t_string() );
+		m_symbolIndices.clear();
+
 		size_t index = 1;
 
-		for ( const auto & p : apiRes.Pairs() ) {
-			AS_LOG_TRACE_LINE( p.name );
+		for ( const auto & p : symbols.Pairs() ) {
+			AS_HUOBI_LOG_TRACE( "{}", p.name );
 
 			as::cryptox::Coin quote = toCoin( p.quoteName.c_str() );
 			as::cryptox::Coin base = toCoin( p.baseName.c_str() );
@@ -207,19 +826,100 @@ namespace as::cryptox::huobi {
 			addSymbolMapEntry(
 				p.name, static_cast<as::cryptox::Symbol>( index ) );
 
+			m_symbolNames[index] = p.name;
+			m_symbolIndices[m_symbolNames[index]] = index;
+
+			if ( m_shmRingPublisher && m_shmSymbolCount == index ) {
+				if ( m_shmRingPublisher->addSymbol(
+						 static_cast<uint32_t>( index ), p.name.c_str() ) ) {
+
+					m_shmSymbolCount = index + 1;
+				}
+			}
+
 			index++;
 		}
 
-		AS_LOG_INFO_LINE( "done" );
+		if ( m_shmRingPublisher && m_shmSymbolCount < index ) {
+			AS_HUOBI_LOG_ERROR( "shm ring: symbol table is full, {} of {} "
+								"symbols are not published",
+				index - m_shmSymbolCount,
+				index - 1 );
+		}
+	}
+
+	void Client::initCoinIndices(
+		const ApiResponseSettingsCommonSymbols & symbols )
+	{
+
+		size_t coinIndex = 0;
+
+		m_coinIndices.clear();
+
+		for ( const auto & c : Coins ) {
+			m_coinIndices[c.first] = static_cast<size_t>( c.second );
+			coinIndex = ( std::max )( coinIndex, m_coinIndices[c.first] + 1 );
+		}
+
+		// reserved once, so that the keys of m_coinIndices stay valid
+		m_coinNames.clear();
+		m_coinNames.reserve( 2 * symbols.Pairs().size() );
+
+		for ( const auto & p : symbols.Pairs() ) {
+			for ( const auto * name : { &p.baseName, &p.quoteName } ) {
+				if ( coinIndex >= BalanceCache::Capacity ||
+					m_coinIndices.count( *name ) > 0 ) {
+
+					continue;
+				}
+
+				m_coinNames.push_back( *name );
+				m_coinIndices[m_coinNames.back()] = coinIndex++;
+			}
+		}
+	}
+
+	void Client::countWsDecodeError( size_t index, size_t error )
+	{
+		m_wsDecodeErrorCounts[index][error].fetch_add(
+			1, std::memory_order_relaxed );
+
+		AS_HUOBI_LOG_TRACE( "{}: decode error {}", index, error );
+	}
+
+	Client::t_ws_decode_error_counts Client::WsDecodeErrorCounts(
+		size_t index ) const
+	{
+
+		const auto & counts = m_wsDecodeErrorCounts[index];
+
+		t_ws_decode_error_counts result;
+		result.inflate = counts[WsMessage::DecodeErrorInflate];
+		result.parse = counts[WsMessage::DecodeErrorParse];
+		result.unknownChannel = counts[WsMessage::DecodeErrorUnknownChannel];
+		result.missingField = counts[WsMessage::DecodeErrorMissingField];
+		result.unknownSymbol = counts[WsMessage::DecodeErrorUnknownSymbol];
+		result.errorResponse = counts[WsMessage::DecodeErrorResponse];
+		result.overflow = counts[WsMessage::DecodeErrorOverflow];
+
+		return result;
 	}
 
 	void Client::initWsClient( size_t index )
 	{
+		auto & state = m_wsClientStates[index];
+		state.isReady = false;
+		state.lastActivityTs = steadyTs();
+		state.reconnectTs = steadyTs();
+		state.isStarted = true;
+
 		as::cryptox::Client::initWsClient( index );
 	}
 
 	ApiResponseSettingsCommonSymbols Client::apiReqSettingsCommonSymbols()
 	{
+		m_rateLimiter.acquire( RateLimiter::GroupCommon );
+
 		auto url = m_httpApiUrls[HttpClientApiIndex].add(
 			ApiRequest::SettingsCommonSymbols() );
 
@@ -228,24 +928,246 @@ namespace as::cryptox::huobi {
 		return ApiResponseSettingsCommonSymbols::deserialize( res );
 	}
 
-	bool Client::subscribe( size_t index, const as::t_string & topicName )
+	size_t Client::toSymbolIndex( std::string_view name ) const
+	{
+		auto it = m_symbolIndices.find( name );
+
+		return it == m_symbolIndices.end() ? 0 : it->second;
+	}
+
+	size_t Client::toCoinIndex( std::string_view name ) const
+	{
+		auto it = m_coinIndices.find( name );
+
+		return it == m_coinIndices.end() ? 0 : it->second;
+	}
+
+	ApiResponseMarketTickers Client::deserializeMarketTickers(
+		const as::t_string & s )
+	{
+
+		return ApiResponseMarketTickers::deserialize(
+			s, m_pairList.size(), [this]( std::string_view name ) {
+				return toSymbolIndex( name );
+			} );
+	}
+
+	ApiResponseMarketTickers Client::apiReqMarketTickers()
+	{
+		m_rateLimiter.acquire( RateLimiter::GroupCommon );
+
+		auto url = m_httpApiUrls[HttpClientApiIndex].add(
+			ApiRequest::MarketTickers() );
+
+		auto res = m_httpClient.get( url, HttpHeaderList() );
+
+		return deserializeMarketTickers( res );
+	}
+
+	ApiResponseCommonTimestamp Client::apiReqCommonTimestamp()
 	{
-		auto buffer =
-			WsMessage::Subscribe( topicName, WsClientApiV2Index == index );
+		m_rateLimiter.acquire( RateLimiter::GroupCommon );
+
+		return getCommonTimestamp();
+	}
+
+	ApiResponseCommonTimestamp Client::getCommonTimestamp()
+	{
+		auto url = m_httpApiUrls[HttpClientApiIndex].add(
+			ApiRequest::CommonTimestamp() );
+
+		auto res = m_httpClient.get( url, HttpHeaderList() );
+
+		return ApiResponseCommonTimestamp::deserialize( res );
+	}
+
+	ApiResponseAccountAccounts Client::apiReqAccountAccounts()
+	{
+		m_rateLimiter.acquire( RateLimiter::GroupAccount );
+
+		auto url = m_httpApiUrls[HttpClientApiIndex].add(
+			signTarget( ApiRequest::AccountAccounts() ) );
+
+		auto res = m_httpClient.get( url, HttpHeaderList() );
+
+		return ApiResponseAccountAccounts::deserialize( res );
+	}
+
+	void Client::requestBalanceSnapshot()
+	{
+		if ( 0 == m_spotAccountId ) {
+			apiReqAccountAccountsAsync(
+				[this]( boost::system::error_code ec,
+					ApiResponseAccountAccounts r ) {
+					if ( ec ) {
+						AS_HUOBI_LOG_ERROR( "spot account: {}", ec.message() );
+						return;
+					}
+
+					if ( 0 == r.SpotAccountId() ) {
+						AS_HUOBI_LOG_ERROR( "no spot account" );
+						return;
+					}
+
+					m_spotAccountId = r.SpotAccountId();
+					requestBalanceSnapshot();
+				} );
+
+			return;
+		}
+
+		auto ts = m_clock.ServerTs();
+
+		apiReqAccountBalanceAsync( m_spotAccountId,
+			[this, ts](
+				boost::system::error_code ec, ApiResponseAccountBalance r ) {
+				if ( ec ) {
+					AS_HUOBI_LOG_ERROR( "balance snapshot: {}", ec.message() );
+					return;
+				}
+
+				for ( const auto & b : r.Balances() ) {
+					auto coinIndex = toCoinIndex( b.currencyName );
+
+					if ( 0 != coinIndex ) {
+						m_balanceCache.seed(
+							coinIndex, b.balance, b.available, ts );
+					}
+				}
+			} );
+	}
+
+	bool Client::writeTopic( size_t index, const as::t_string & topicName )
+	{
+		WsMessageBuffer buffer;
+
+		if ( !WsMessage::Subscribe( buffer,
+				 topicName,
+				 WsClientApiV2Index == wsLogicalIndex( index ) ) ) {
+
+			AS_HUOBI_LOG_ERROR( "topic name is too long: {}", topicName );
+			return false;
+		}
+
+		WsClientUse use( m_wsClientStates[index], true );
 
 		auto r = callWsClient<bool>( index, [&buffer]( WsClient * client ) {
-			client->write( buffer.c_str(), buffer.length() );
+			client->write( buffer.Data(), buffer.Size() );
 			return true;
 		} );
 
 		return ( r.first && r.second );
 	}
 
+	bool Client::subscribe( size_t index, const as::t_string & topicName )
+	{
+		auto logicalIndex = wsLogicalIndex( index );
+		auto count = wsClientCount();
+		bool r = false;
+
+		{
+			std::lock_guard<std::mutex> lock( m_wsTopicsSync );
+
+			auto & topics = m_wsTopics[logicalIndex];
+
+			if ( std::find( topics.begin(), topics.end(), topicName ) ==
+				topics.end() ) {
+
+				topics.push_back( topicName );
+			}
+		}
+
+		// written outside the lock: writeTopic() waits for a connection
+		// being swapped, and the swap may replay the topics under it, on
+		// the thread doing it; connections which are not ready yet get it
+		// replayed once they are
+		for ( size_t i = 0; i < count; i++ ) {
+			if ( wsLogicalIndex( i ) == logicalIndex &&
+				m_wsClientStates[i].isReady ) {
+				r = writeTopic( i, topicName ) || r;
+			}
+		}
+
+		return r;
+	}
+
+	bool Client::subscribeChannel( size_t wsClientIndex,
+		size_t kind,
+		std::string_view symbolName,
+		std::string_view param )
+	{
+
+		auto topic = Channel::topic( kind, symbolName, param );
+
+		if ( topic.empty() ) {
+			AS_HUOBI_LOG_ERROR(
+				"no topic of kind {} for {}", kind, symbolName );
+
+			return false;
+		}
+
+		AS_HUOBI_LOG_TRACE( "{}", topic.View() );
+
+		return subscribe( wsClientIndex, as::t_string( topic.View() ) );
+	}
+
+	void Client::addWsClient( size_t logicalIndex, const as::Url & url )
+	{
+		if ( m_wsApiUrls.size() >= WsClientMaxCount ) {
+			throw ::as::Exception( AS_T( "too many ws connections" ) );
+		}
+
+		m_wsLogicalIndices[m_wsApiUrls.size()] = logicalIndex;
+		m_wsApiUrls.push_back( url );
+	}
+
 	void Client::run( const t_exchangeClientReadyHandler & handler,
 		const std::function<void( size_t )> & beforeRun )
 	{
 
+		if ( m_wsApiUrls.size() == WsClientCount ) {
+			if ( m_isWsStandbyEnabled ) {
+				for ( size_t i = 0; i < WsClientCount; i++ ) {
+					addWsClient( i, m_wsApiUrls[i] );
+				}
+			}
+
+			for ( const auto & line : m_wsFeedLines ) {
+				addWsClient( line.first, as::Url( line.second ) );
+				m_isWsFeedArbitrated[line.first] = true;
+			}
+		}
+
+		if ( m_wsDecodeThreadCount > 0 ) {
+			m_decodePipeline = std::make_unique<DecodePipeline>(
+				m_wsDecodeThreadCount,
+				m_wsApiUrls.size(),
+				WsDecodePipelineCapacity,
+				[this]( Inflater & inflater, DecodePipeline::t_frame & frame ) {
+					// messages outlive the worker's next frame, no cache
+					frame.message = decodeWsFrame( frame.wsClientIndex,
+						inflater,
+						nullptr,
+						frame.data.data(),
+						frame.size,
+						frame.error );
+				},
+				[this]( DecodePipeline::t_frame & frame ) {
+					if ( WsMessage::DecodeErrorNone != frame.error ) {
+						countWsDecodeError( frame.wsClientIndex, frame.error );
+						return;
+					}
+
+					dispatchWsMessage(
+						frame.wsClientIndex, nullptr, *frame.message );
+				} );
+		}
+
+		startService();
 		as::cryptox::Client::run( handler );
+		stopService();
+
+		m_decodePipeline.reset();
 	}
 
 	bool Client::subscribePriceBookTicker( size_t wsClientIndex,
@@ -260,12 +1182,8 @@ namespace as::cryptox::huobi {
 		as::cryptox::Client::subscribePriceBookTicker(
 			wsClientIndex, symbol, handler );
 
-		auto topicName = as::t_string( AS_T( "market." ) ) + toName( symbol ) +
-			AS_T( ".bbo" );
-
-		AS_LOG_TRACE_LINE( topicName );
-
-		return subscribe( wsClientIndex, topicName );
+		return subscribeChannel(
+			wsClientIndex, Channel::KindBbo, toName( symbol ) );
 	}
 
 	void Client::subscribeOrderUpdate(
@@ -279,6 +1197,54 @@ namespace as::cryptox::huobi {
 		}
 	}
 
+	bool Client::subscribeAccountBalance( size_t wsClientIndex )
+	{
+		if ( WsClientApiV2Index != wsClientIndex ) {
+			return false;
+		}
+
+		m_isBalanceSubscribed = true;
+
+		// subscribed first, so that the snapshot cannot miss a change; the
+		// pushes are dropped until the spot account id is known, which the
+		// snapshot looks up first if need be
+		auto r = subscribeChannel(
+			wsClientIndex, Channel::KindAccountsUpdate, {}, "1" );
+		requestBalanceSnapshot();
+
+		return r;
+	}
+
+	bool Client::subscribeDepth( size_t wsClientIndex,
+		as::cryptox::Symbol symbol,
+		const t_depthHandler & handler )
+	{
+
+		if ( WsClientApiIndex != wsClientIndex ) {
+			return false;
+		}
+
+		m_depthHandlerMap[symbol] = handler;
+
+		return subscribeChannel(
+			wsClientIndex, Channel::KindDepth, toName( symbol ), "0" );
+	}
+
+	bool Client::subscribeTrades( size_t wsClientIndex,
+		as::cryptox::Symbol symbol,
+		const t_tradeHandler & handler )
+	{
+
+		if ( WsClientApiIndex != wsClientIndex ) {
+			return false;
+		}
+
+		m_tradeHandlerMap[symbol] = handler;
+
+		return subscribeChannel(
+			wsClientIndex, Channel::KindTrade, toName( symbol ) );
+	}
+
 	t_order Client::placeOrder( Direction direction,
 		as::cryptox::Symbol symbol,
 		const FixedNumber & price,
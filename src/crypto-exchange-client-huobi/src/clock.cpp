@@ -0,0 +1,126 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// clock.cpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#include <algorithm>
+
+#include "crypto-exchange-client-huobi/clock.hpp"
+
+
+namespace as::cryptox::huobi {
+
+	Clock::Clock()
+	{
+		m_firstTsc = tsc();
+		m_firstTs = systemTs();
+
+		m_baseTsc = m_firstTsc;
+		m_baseTs = m_firstTs;
+	}
+
+	void Clock::calibrate()
+	{
+#if defined( AS_HUOBI_CLOCK_TSC )
+		auto t = tsc();
+		auto ts = systemTs();
+
+		if ( t == m_firstTsc ) {
+			return;
+		}
+
+		// the first anchor gives the longest baseline for the rate
+		double nsPerTick = static_cast<double>( ts - m_firstTs ) /
+			static_cast<double>( t - m_firstTsc );
+
+		auto seq = m_seq.load( std::memory_order_relaxed );
+		m_seq.store( seq + 1, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+
+		m_baseTsc.store( t, std::memory_order_relaxed );
+		m_baseTs.store( ts, std::memory_order_relaxed );
+		m_nsPerTick.store( nsPerTick, std::memory_order_relaxed );
+
+		m_seq.store( seq + 2, std::memory_order_release );
+#endif
+	}
+
+	void Clock::addSample( int64_t offset, int64_t rtt )
+	{
+		m_samples[m_sampleIndex] = { offset, rtt };
+		m_sampleIndex = ( m_sampleIndex + 1 ) % WindowSize;
+		m_sampleCount = ( std::min )( m_sampleCount + 1, WindowSize );
+
+		// ties go to the latest one
+		size_t best = ( m_sampleIndex + WindowSize - 1 ) % WindowSize;
+
+		for ( size_t i = 0; i < m_sampleCount; i++ ) {
+			if ( m_samples[i].rtt < m_samples[best].rtt ) {
+				best = i;
+			}
+		}
+
+		m_offset.store( m_samples[best].offset, std::memory_order_relaxed );
+		m_rtt.store( m_samples[best].rtt, std::memory_order_relaxed );
+	}
+
+	void Clock::sample( int64_t sendTs, int64_t serverTs, int64_t recvTs )
+	{
+		auto rtt = recvTs - sendTs;
+
+		if ( rtt < 0 || rtt > MaxRtt ) {
+			return;
+		}
+
+		// the server is assumed to answer half way through
+		auto offset = serverTs * 1000000 - ( sendTs + rtt / 2 );
+
+		std::lock_guard<std::mutex> lock( m_samplesSync );
+
+		if ( 0 == m_minRtt || rtt < m_minRtt ) {
+			m_minRtt = rtt;
+		}
+
+		addSample( offset, rtt );
+	}
+
+	void Clock::sampleOneWay( int64_t serverTs, int64_t recvTs )
+	{
+		// time in flight plus the offset, only differences matter
+		auto lag = recvTs - serverTs * 1000000;
+
+		std::lock_guard<std::mutex> lock( m_samplesSync );
+
+		m_lags[m_lagIndex] = lag;
+		m_lagIndex = ( m_lagIndex + 1 ) % WindowSize;
+		m_lagCount = ( std::min )( m_lagCount + 1, WindowSize );
+
+		auto minLag =
+			*std::min_element( m_lags.begin(), m_lags.begin() + m_lagCount );
+
+		// taken as a round trip as short as the best one seen, stretched by
+		// however much later than the quickest recent one it arrived
+		addSample( -lag + m_minRtt / 2, m_minRtt + lag - minLag );
+	}
+
+} // namespace as::cryptox::huobi
@@ -0,0 +1,254 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// decodePipeline.cpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#include <cstring>
+
+#include "crypto-exchange-client-huobi/decodePipeline.hpp"
+
+
+namespace as::cryptox::huobi {
+
+	static size_t toPowerOf2( size_t n )
+	{
+		size_t result = 1;
+
+		while ( result < n ) {
+			result <<= 1;
+		}
+
+		return result;
+	}
+
+	DecodePipeline::DecodePipeline( size_t threadCount,
+		size_t connectionCount,
+		size_t capacity,
+		const t_decoder & decoder,
+		const t_deliverer & deliverer )
+		: m_decoder( decoder )
+		, m_deliverer( deliverer )
+		, m_capacity( toPowerOf2( capacity ) )
+		, m_queue( m_capacity )
+		, m_sequencerCount( connectionCount )
+	{
+
+		m_frames.reset( new t_frame[m_capacity] );
+
+		for ( size_t i = 0; i < m_capacity; i++ ) {
+			m_frames[i].next = i + 1 < m_capacity
+				? static_cast<uint32_t>( i + 1 )
+				: None;
+		}
+
+		// a connection may have every buffer in flight
+		m_sequencers.reset( new t_sequencer[m_sequencerCount] );
+
+		for ( size_t i = 0; i < m_sequencerCount; i++ ) {
+			auto & sequencer = m_sequencers[i];
+			sequencer.slots.reset( new std::atomic<uint32_t>[m_capacity] );
+
+			for ( size_t j = 0; j < m_capacity; j++ ) {
+				sequencer.slots[j] = None;
+			}
+		}
+
+		m_freeHead = 0;
+
+		for ( size_t i = 0; i < threadCount; i++ ) {
+			m_workers.emplace_back( [this]() {
+				work();
+			} );
+		}
+	}
+
+	DecodePipeline::~DecodePipeline()
+	{
+		m_isRunning = false;
+
+		{
+			std::lock_guard<std::mutex> lock( m_sleepSync );
+			m_sleepCondition.notify_all();
+		}
+
+		for ( auto & worker : m_workers ) {
+			worker.join();
+		}
+	}
+
+	uint32_t DecodePipeline::acquireFrame()
+	{
+		auto head = m_freeHead.load( std::memory_order_acquire );
+
+		while ( true ) {
+			auto index = static_cast<uint32_t>( head );
+
+			if ( None == index ) {
+				return None;
+			}
+
+			uint64_t next =
+				m_frames[index].next.load( std::memory_order_relaxed );
+			uint64_t newHead = ( ( ( head >> 32 ) + 1 ) << 32 ) | next;
+
+			if ( m_freeHead.compare_exchange_weak( head,
+					 newHead,
+					 std::memory_order_acquire,
+					 std::memory_order_acquire ) ) {
+
+				return index;
+			}
+		}
+	}
+
+	void DecodePipeline::releaseFrame( uint32_t index )
+	{
+		auto head = m_freeHead.load( std::memory_order_relaxed );
+		uint64_t newHead;
+
+		do {
+			m_frames[index].next.store(
+				static_cast<uint32_t>( head ), std::memory_order_relaxed );
+
+			newHead = ( ( ( head >> 32 ) + 1 ) << 32 ) | index;
+		} while ( !m_freeHead.compare_exchange_weak( head,
+			newHead,
+			std::memory_order_release,
+			std::memory_order_relaxed ) );
+	}
+
+	bool DecodePipeline::submit(
+		size_t wsClientIndex, const char * data, size_t size )
+	{
+
+		auto index = acquireFrame();
+
+		if ( None == index ) {
+			return false;
+		}
+
+		auto & frame = m_frames[index];
+		frame.wsClientIndex = wsClientIndex;
+
+		// grows to the largest frame seen, then stays
+		if ( frame.data.size() < size ) {
+			frame.data.resize( size );
+		}
+
+		std::memcpy( frame.data.data(), data, size );
+		frame.size = size;
+		frame.seq = m_sequencers[wsClientIndex].nextSeq.fetch_add(
+			1, std::memory_order_relaxed );
+
+		m_queue.push( index );
+		m_queuedCount.fetch_add( 1 );
+
+		if ( m_sleeperCount.load() > 0 ) {
+			std::lock_guard<std::mutex> lock( m_sleepSync );
+			m_sleepCondition.notify_one();
+		}
+
+		return true;
+	}
+
+	void DecodePipeline::work()
+	{
+		Inflater inflater;
+		size_t idleCount = 0;
+
+		while ( m_isRunning ) {
+			uint32_t index;
+
+			if ( m_queue.pop( index ) ) {
+				m_queuedCount.fetch_sub( 1 );
+				idleCount = 0;
+
+				m_decoder( inflater, m_frames[index] );
+				complete( index );
+
+				continue;
+			}
+
+			if ( ++idleCount < SpinCount ) {
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock( m_sleepSync );
+			m_sleeperCount++;
+
+			m_sleepCondition.wait( lock, [this]() {
+				return m_queuedCount.load() > 0 || !m_isRunning;
+			} );
+
+			m_sleeperCount--;
+			idleCount = 0;
+		}
+	}
+
+	void DecodePipeline::complete( uint32_t index )
+	{
+		auto mask = m_capacity - 1;
+		auto & sequencer = m_sequencers[m_frames[index].wsClientIndex];
+
+		sequencer.slots[m_frames[index].seq & mask].store( index );
+
+		while ( true ) {
+			// somebody else is delivering and will pick this one up
+			if ( sequencer.isDelivering.test_and_set() ) {
+				return;
+			}
+
+			auto seq =
+				sequencer.nextDeliverSeq.load( std::memory_order_relaxed );
+
+			while ( true ) {
+				auto & slot = sequencer.slots[seq & mask];
+				auto i = slot.load();
+
+				if ( None == i ) {
+					break;
+				}
+
+				slot.store( None, std::memory_order_relaxed );
+				seq++;
+				sequencer.nextDeliverSeq.store(
+					seq, std::memory_order_relaxed );
+
+				auto & frame = m_frames[i];
+				m_deliverer( frame );
+				frame.message.reset();
+
+				releaseFrame( i );
+			}
+
+			sequencer.isDelivering.clear();
+
+			// the next frame may have completed after the check above but
+			// before the flag was cleared
+			if ( None == sequencer.slots[seq & mask].load() ) {
+				return;
+			}
+		}
+	}
+
+} // namespace as::cryptox::huobi
@@ -0,0 +1,78 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// feedArbiter.cpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#include "crypto-exchange-client-huobi/feedArbiter.hpp"
+
+
+namespace as::cryptox::huobi {
+
+	void FeedArbiter::init( size_t keyCount )
+	{
+		m_keyCount = keyCount;
+		m_lastSeqs.reset( new uint64_t[StreamCount * keyCount]() );
+		// one per key, a symbol's streams are delivered one at a time too
+		m_syncs.reset( new std::mutex[keyCount] );
+	}
+
+	FeedArbiter::t_line_stats FeedArbiter::LineStats( size_t line ) const
+	{
+		const auto & l = m_lines[line];
+
+		t_line_stats result{};
+		result.count = l.count.load( std::memory_order_relaxed );
+		result.firstCount = l.firstCount.load( std::memory_order_relaxed );
+
+		std::array<uint64_t, LatencyBucketCount> latencies;
+		uint64_t total = 0;
+
+		for ( size_t i = 0; i < LatencyBucketCount; i++ ) {
+			latencies[i] = l.latencies[i].load( std::memory_order_relaxed );
+			total += latencies[i];
+		}
+
+		uint64_t p50 = ( total + 1 ) / 2;
+		uint64_t p99 = total - total / 100;
+		uint64_t sum = 0;
+
+		result.latencyP50 = -1;
+		result.latencyP99 = -1;
+
+		for ( size_t i = 0; i < LatencyBucketCount && total > 0; i++ ) {
+			sum += latencies[i];
+
+			if ( result.latencyP50 < 0 && sum >= p50 ) {
+				result.latencyP50 = static_cast<int64_t>( i );
+			}
+
+			if ( sum >= p99 ) {
+				result.latencyP99 = static_cast<int64_t>( i );
+				break;
+			}
+		}
+
+		return result;
+	}
+
+} // namespace as::cryptox::huobi
@@ -0,0 +1,106 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// inflater.cpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#include <cstring>
+
+#include "crypto-exchange-client-huobi/inflater.hpp"
+
+
+namespace as::cryptox::huobi {
+
+	Inflater::Inflater()
+		: m_buffer( InitialCapacity )
+	{
+
+		std::memset( &m_stream, 0, sizeof( m_stream ) );
+
+		// 16 + window bits: gzip header and trailer expected
+		m_isInitialized = inflateInit2( &m_stream, 16 + MAX_WBITS ) == Z_OK;
+	}
+
+	Inflater::~Inflater()
+	{
+		if ( m_isInitialized ) {
+			inflateEnd( &m_stream );
+		}
+	}
+
+	bool Inflater::inflate( const char * data, size_t size )
+	{
+		m_size = 0;
+
+		if ( !m_isInitialized || inflateReset( &m_stream ) != Z_OK ) {
+			return false;
+		}
+
+		m_stream.next_in =
+			reinterpret_cast<Bytef *>( const_cast<char *>( data ) );
+
+		m_stream.avail_in = static_cast<uInt>( size );
+
+		while ( true ) {
+			if ( m_size + Padding == m_buffer.size() ) {
+				m_buffer.resize( m_buffer.size() * 2 );
+			}
+
+			auto avail = m_buffer.size() - Padding - m_size;
+
+			m_stream.next_out =
+				reinterpret_cast<Bytef *>( m_buffer.data() + m_size );
+
+			m_stream.avail_out = static_cast<uInt>( avail );
+
+			auto r = ::inflate( &m_stream, Z_NO_FLUSH );
+			m_size += avail - m_stream.avail_out;
+
+			if ( Z_STREAM_END == r ) {
+				return true;
+			}
+
+			// Z_BUF_ERROR with output space left means truncated input
+			if ( ( Z_OK != r && Z_BUF_ERROR != r ) ||
+				( m_stream.avail_out > 0 && 0 == m_stream.avail_in ) ) {
+
+				return false;
+			}
+		}
+	}
+
+	size_t Inflater::InflatedSize( const char * data, size_t size )
+	{
+		// 10 bytes of header, 8 of trailer: crc32 and isize, little endian
+		if ( size < 18 || data[0] != '\x1f' || data[1] != '\x8b' ) {
+			return SIZE_MAX;
+		}
+
+		auto p = reinterpret_cast<const uint8_t *>( data + size - 4 );
+
+		return static_cast<size_t>( p[0] ) |
+			( static_cast<size_t>( p[1] ) << 8 ) |
+			( static_cast<size_t>( p[2] ) << 16 ) |
+			( static_cast<size_t>( p[3] ) << 24 );
+	}
+
+} // namespace as::cryptox::huobi
@@ -0,0 +1,98 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// json.cpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#include <string>
+
+#include "crypto-exchange-client-huobi/json.hpp"
+
+
+namespace as::cryptox::huobi {
+
+#if defined( AS_HUOBI_JSON_SIMDJSON )
+	static_assert( JsonDocument::Padding >= simdjson::SIMDJSON_PADDING );
+
+	bool JsonDocument::parse( const char * data, size_t size, size_t capacity )
+	{
+		static thread_local simdjson::ondemand::parser parser;
+		static thread_local std::string buffer;
+
+		if ( capacity < size + Padding ) {
+			buffer.reserve( size + Padding );
+			buffer.assign( data, size );
+
+			data = buffer.data();
+			capacity = buffer.capacity();
+		}
+
+		return !parser.iterate( data, size, capacity ).get( m_document ) &&
+			!m_document.get_value().get( m_root.m_value );
+	}
+#else
+	static thread_local size_t s_documentCount = 0;
+
+	static boost::json::monotonic_resource & arena()
+	{
+		static thread_local unsigned char buffer[JsonDocument::ArenaSize];
+		static thread_local boost::json::monotonic_resource resource(
+			buffer, sizeof( buffer ) );
+
+		return resource;
+	}
+
+	JsonDocument::JsonDocument()
+		: m_document( &arena() )
+	{
+		s_documentCount++;
+	}
+
+	JsonDocument::~JsonDocument()
+	{
+		s_documentCount--;
+	}
+
+	bool JsonDocument::parse( const char * data, size_t size, size_t )
+	{
+		boost::json::error_code ec;
+
+		m_document = nullptr;
+
+		if ( 1 == s_documentCount ) {
+			arena().release();
+		}
+
+		m_document =
+			boost::json::parse( { data, size }, ec, m_document.storage() );
+
+		if ( ec || !( m_document.is_object() || m_document.is_array() ) ) {
+			return false;
+		}
+
+		m_root.m_value = &m_document;
+
+		return true;
+	}
+#endif
+
+} // namespace as::cryptox::huobi
@@ -0,0 +1,288 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// logger.cpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#include <algorithm>
+#include <cinttypes>
+
+#include "crypto-exchange-client-huobi/logger.hpp"
+
+
+namespace as::cryptox::huobi {
+
+	// a backstop, flush() wakes the background thread up
+	static const std::chrono::milliseconds IdlePeriod( 50 );
+
+	static const char * LevelNames[] = { "TRACE", "INFO", "ERROR" };
+
+	Logger::Logger()
+	{
+		m_thread = std::thread( [this]() {
+			process();
+		} );
+	}
+
+	Logger::~Logger()
+	{
+		m_isRunning = false;
+
+		{
+			std::lock_guard<std::mutex> lock( m_wakeSync );
+			m_isWakeRequested = true;
+			m_wakeCondition.notify_one();
+		}
+
+		if ( m_thread.joinable() ) {
+			m_thread.join();
+		}
+	}
+
+	Logger & Logger::instance()
+	{
+		static Logger logger;
+		return logger;
+	}
+
+	Logger::Ring * Logger::acquireRing()
+	{
+		std::lock_guard<std::mutex> lock( m_ringsSync );
+
+		// reuse rings left by finished threads
+		for ( auto & ring : m_rings ) {
+			bool isOwned = false;
+
+			if ( ring->isOwned.compare_exchange_strong( isOwned, true ) ) {
+				return ring.get();
+			}
+		}
+
+		m_rings.push_back( std::make_unique<Ring>() );
+		m_rings.back()->isOwned = true;
+
+		return m_rings.back().get();
+	}
+
+	Logger::Ring * Logger::threadRing()
+	{
+		struct t_ring_holder {
+			Ring * ring;
+
+			t_ring_holder()
+				: ring( instance().acquireRing() )
+			{
+			}
+
+			~t_ring_holder()
+			{
+				ring->isOwned = false;
+			}
+		};
+
+		thread_local t_ring_holder holder;
+
+		return holder.ring;
+	}
+
+	uint64_t Logger::DropCount()
+	{
+		std::lock_guard<std::mutex> lock( m_ringsSync );
+		uint64_t result = 0;
+
+		for ( auto & ring : m_rings ) {
+			result += ring->dropCount.load( std::memory_order_relaxed );
+		}
+
+		return result;
+	}
+
+	void Logger::flush()
+	{
+		// what has been written to every ring so far
+		std::vector<std::pair<Ring *, size_t>> marks;
+
+		{
+			std::lock_guard<std::mutex> lock( m_ringsSync );
+
+			for ( auto & ring : m_rings ) {
+				marks.emplace_back( ring.get(), ring->WriteCount() );
+			}
+		}
+
+		{
+			std::unique_lock<std::mutex> lock( m_wakeSync );
+
+			m_isWakeRequested = true;
+			m_wakeCondition.notify_one();
+
+			m_drainCondition.wait( lock, [&marks]() {
+				for ( const auto & mark : marks ) {
+					if ( mark.first->ReadCount() < mark.second ) {
+						return false;
+					}
+				}
+
+				return true;
+			} );
+		}
+
+		auto output = m_output.load();
+
+		if ( nullptr != output ) {
+			fflush( output );
+		}
+	}
+
+	void Logger::process()
+	{
+		std::string buffer;
+
+		while ( true ) {
+			bool isRunning = m_isRunning;
+			auto count = drain( buffer );
+
+			std::unique_lock<std::mutex> lock( m_wakeSync );
+
+			// for flush()
+			m_drainCondition.notify_all();
+
+			if ( count == 0 ) {
+				if ( !isRunning ) {
+					break;
+				}
+
+				m_wakeCondition.wait_for( lock, IdlePeriod, [this]() {
+					return m_isWakeRequested;
+				} );
+
+				m_isWakeRequested = false;
+			}
+		}
+
+		auto output = m_output.load();
+
+		if ( nullptr != output ) {
+			fflush( output );
+		}
+	}
+
+	size_t Logger::drain( std::string & buffer )
+	{
+		std::vector<Ring *> rings;
+
+		{
+			std::lock_guard<std::mutex> lock( m_ringsSync );
+
+			for ( auto & ring : m_rings ) {
+				rings.push_back( ring.get() );
+			}
+		}
+
+		size_t count = 0;
+		auto output = m_output.load();
+
+		for ( auto ring : rings ) {
+			const t_record * record;
+
+			while ( nullptr != ( record = ring->beginRead() ) ) {
+				buffer.clear();
+				format( *record, buffer );
+				ring->endRead();
+
+				if ( nullptr != output ) {
+					fwrite( buffer.data(), 1, buffer.size(), output );
+				}
+
+				count++;
+			}
+		}
+
+		return count;
+	}
+
+	void Logger::format( const t_record & record, std::string & buffer )
+	{
+		char s[64];
+
+		snprintf( s,
+			sizeof( s ),
+			"%" PRId64 ".%06" PRId64 " %s ",
+			record.ts / 1000000,
+			record.ts % 1000000,
+			LevelNames[( std::min )( record.level, uint8_t( 2 ) )] );
+
+		buffer += s;
+
+		size_t argIndex = 0;
+
+		for ( auto p = record.format; *p != 0; p++ ) {
+			if ( p[0] != '{' || p[1] != '}' || argIndex >= record.argCount ) {
+				buffer += *p;
+				continue;
+			}
+
+			p++;
+
+			const auto & arg = record.args[argIndex++];
+
+			switch ( arg.type ) {
+				case ArgInt:
+					snprintf( s, sizeof( s ), "%" PRId64, arg.i );
+					buffer += s;
+					break;
+
+				case ArgUInt:
+					snprintf( s, sizeof( s ), "%" PRIu64, arg.u );
+					buffer += s;
+					break;
+
+				case ArgDouble:
+					snprintf( s, sizeof( s ), "%.10g", arg.d );
+					buffer += s;
+					break;
+
+				case ArgLiteral:
+					buffer += arg.s;
+					break;
+
+				case ArgBytes:
+					buffer.append(
+						record.payload + arg.bytes.offset, arg.bytes.size );
+
+					if ( arg.bytes.size < arg.bytes.originalSize ) {
+						snprintf( s,
+							sizeof( s ),
+							"...(%" PRIu32 " bytes)",
+							arg.bytes.originalSize );
+
+						buffer += s;
+					}
+
+					break;
+			}
+		}
+
+		buffer += '\n';
+	}
+
+} // namespace as::cryptox::huobi
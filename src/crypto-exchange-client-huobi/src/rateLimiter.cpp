@@ -0,0 +1,229 @@
+/*
+MIT License
+Copyright (c) 2022 Denis Rozhkov <denis@rozhkoff.com>
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/// rateLimiter.cpp
+///
+/// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
+///
+
+#include <algorithm>
+#include <thread>
+
+#include "crypto-exchange-client-huobi/rateLimiter.hpp"
+
+
+namespace as::cryptox::huobi {
+
+	RateLimiter::RateLimiter( boost::asio::io_context & ioContext )
+		: m_ioContext( ioContext )
+		, m_timer( ioContext )
+	{
+
+		for ( auto & g : m_groups ) {
+			for ( auto & q : g.queues ) {
+				q = std::make_unique<MpmcQueue<t_job>>( QueueCapacity );
+			}
+		}
+
+		limit( GroupTrade, 100, std::chrono::milliseconds( 2000 ) );
+		limit( GroupAccount, 100, std::chrono::milliseconds( 2000 ) );
+		limit( GroupCommon, 10, std::chrono::milliseconds( 1000 ) );
+	}
+
+	void RateLimiter::limit(
+		size_t group, size_t count, std::chrono::milliseconds period )
+	{
+
+		auto & g = m_groups[group];
+		auto periodNs =
+			std::chrono::duration_cast<std::chrono::nanoseconds>( period )
+				.count();
+
+		g.period = periodNs;
+		g.interval = periodNs / static_cast<int64_t>( ( std::max )(
+									count, static_cast<size_t>( 1 ) ) );
+	}
+
+	bool RateLimiter::tryAcquire( size_t group )
+	{
+		auto & g = m_groups[group];
+		auto now = steadyTs();
+		auto interval = g.interval.load( std::memory_order_relaxed );
+		auto period = g.period.load( std::memory_order_relaxed );
+		auto tat = g.tat.load( std::memory_order_relaxed );
+		int64_t next;
+
+		do {
+			next = ( std::max )( tat, now ) + interval;
+
+			if ( next - now > period ) {
+				return false;
+			}
+		} while ( !g.tat.compare_exchange_weak(
+			tat, next, std::memory_order_relaxed ) );
+
+		return true;
+	}
+
+	void RateLimiter::acquire( size_t group )
+	{
+		auto & g = m_groups[group];
+
+		while ( !tryAcquire( group ) ) {
+			auto wait = g.tat.load( std::memory_order_relaxed ) +
+				g.interval.load( std::memory_order_relaxed ) -
+				g.period.load( std::memory_order_relaxed ) - steadyTs();
+
+			wait = ( std::max )( wait, int64_t( 0 ) );
+			std::this_thread::sleep_for( std::chrono::nanoseconds( wait ) );
+		}
+	}
+
+	size_t RateLimiter::Remaining( size_t group ) const
+	{
+		auto & g = m_groups[group];
+		auto now = steadyTs();
+		auto interval = g.interval.load( std::memory_order_relaxed );
+		auto period = g.period.load( std::memory_order_relaxed );
+		auto used = ( std::max )(
+			g.tat.load( std::memory_order_relaxed ) - now, int64_t( 0 ) );
+
+		return interval > 0
+			? static_cast<size_t>( ( period - used ) / interval )
+			: 0;
+	}
+
+	bool RateLimiter::submit( size_t group, size_t priority, t_job && job )
+	{
+		auto & g = m_groups[group];
+
+		if ( !g.queues[priority]->push( std::move( job ) ) ) {
+			return false;
+		}
+
+		// seq_cst, as is m_isArmed, so that a pass going idle either sees
+		// the job or leaves the flag for this submit to find cleared
+		g.queuedCount.fetch_add( 1 );
+		scheduleRelease();
+
+		return true;
+	}
+
+	void RateLimiter::scheduleRelease()
+	{
+		if ( m_isArmed.exchange( true ) ) {
+			return;
+		}
+
+		boost::asio::post( m_ioContext, [this]() {
+			release();
+		} );
+	}
+
+	void RateLimiter::release()
+	{
+		while ( true ) {
+			auto wait = releaseReady();
+
+			if ( wait >= 0 ) {
+				// stays armed, submits meanwhile are left to the timer
+				m_timer.expires_after( std::chrono::nanoseconds( wait ) );
+				m_timer.async_wait(
+					[this]( const boost::system::error_code & ec ) {
+						if ( ec ) {
+							m_isArmed = false;
+							return;
+						}
+
+						release();
+					} );
+
+				return;
+			}
+
+			// going idle; a job submitted before the flag is cleared is
+			// picked up here, one after it posts a pass of its own
+			m_isArmed = false;
+
+			if ( isQueueEmpty() || m_isArmed.exchange( true ) ) {
+				return;
+			}
+		}
+	}
+
+	bool RateLimiter::isQueueEmpty() const
+	{
+		for ( const auto & g : m_groups ) {
+			if ( g.queuedCount.load() > 0 ) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	int64_t RateLimiter::releaseReady()
+	{
+		int64_t wait = -1;
+
+		for ( size_t i = 0; i < GroupCount; i++ ) {
+			auto & g = m_groups[i];
+
+			while ( g.queuedCount.load( std::memory_order_acquire ) > 0 ) {
+				// a job is only taken off its queue when there is a token
+				// for it, so that a more urgent one can still overtake it
+				if ( !g.next && Remaining( i ) > 0 ) {
+					for ( auto & q : g.queues ) {
+						if ( q->pop( g.next ) ) {
+							break;
+						}
+					}
+
+					// not expected, a job is counted only once pushed
+					if ( !g.next ) {
+						break;
+					}
+				}
+
+				if ( !g.next || !tryAcquire( i ) ) {
+					auto w = g.tat.load( std::memory_order_relaxed ) +
+						g.interval.load( std::memory_order_relaxed ) -
+						g.period.load( std::memory_order_relaxed ) - steadyTs();
+
+					if ( wait < 0 || w < wait ) {
+						wait = ( std::max )( w, int64_t( 0 ) );
+					}
+
+					break;
+				}
+
+				auto job = std::move( g.next );
+				g.next = nullptr;
+				g.queuedCount.fetch_sub( 1, std::memory_order_relaxed );
+
+				// starts the request, its completion does not run inline
+				job();
+			}
+		}
+
+		return wait;
+	}
+
+} // namespace as::cryptox::huobi
@@ -23,98 +23,394 @@ SOFTWARE.
 /// 0.0 - created (Denis Rozhkov <denis@rozhkoff.com>)
 ///
 
+#include <cmath>
+#include <charconv>
+
 #include "crypto-exchange-client-huobi/wsMessage.hpp"
 
 
 namespace as::cryptox::huobi {
 
+	/// amounts are sent as strings; a missing one is NaN, a malformed one
+	/// is an error
+	static bool amountField( JsonValue & v, std::string_view key, double & n )
+	{
+		JsonValue f;
+
+		if ( !v.field( key, f ) || f.isNull() ) {
+			n = std::nan( "" );
+			return true;
+		}
+
+		std::string_view s;
+
+		if ( f.toString( s ) ) {
+			auto r = std::from_chars( s.data(), s.data() + s.size(), n );
+
+			return r.ec == std::errc() && r.ptr == s.data() + s.size();
+		}
+
+		return f.toDouble( n );
+	}
+
+	/// the symbol out of market.$symbol.*
+	static bool channelSymbolName( JsonValue & v, as::t_string & symbolName )
+	{
+		std::string_view ch;
+
+		if ( !v.stringField( "ch", ch ) ) {
+			return false;
+		}
+
+		auto channel = Channel::classify( ch );
+
+		if ( channel.symbol.empty() ) {
+			return false;
+		}
+
+		symbolName.assign( channel.symbol.data(), channel.symbol.size() );
+
+		return true;
+	}
+
+	/// [[price, size], ...], the best levels.size() only
+	static bool levelsField( JsonValue & v,
+		std::string_view key,
+		std::array<t_depth_level, t_depth::LevelCount> & levels,
+		size_t & count )
+	{
+
+		JsonValue f;
+		bool isOk = true;
+
+		count = 0;
+
+		if ( !v.field( key, f ) ) {
+			return false;
+		}
+
+		isOk = f.forEach( [&]( JsonValue & level ) {
+			auto & l = levels[count];
+			size_t i = 0;
+
+			bool isLevelOk = level.forEach( [&]( JsonValue & e ) {
+				i++;
+
+				return ( 1 == i && e.toDouble( l.price ) ) ||
+					( 2 == i && e.toDouble( l.size ) );
+			} );
+
+			if ( !isLevelOk || i != 2 ) {
+				isOk = false;
+				return false;
+			}
+
+			return ++count < levels.size();
+		} ) && isOk;
+
+		return isOk;
+	}
+
+	template <typename T>
+	static std::shared_ptr<T> make( WsMessageCache * cache )
+	{
+		return nullptr == cache ? std::make_shared<T>() : cache->get<T>();
+	}
+
+	////
+
 	std::shared_ptr<::as::cryptox::ApiMessageBase> WsMessage::deserialize(
-		const char * data, size_t size, bool isV2 )
+		const char * data,
+		size_t size,
+		size_t capacity,
+		bool isV2,
+		WsMessageCache * cache,
+		size_t & error )
 	{
 
-		auto v = boost::json::parse( { data, size } );
-		auto & v1 = v;
+		error = DecodeErrorNone;
+
+		JsonDocument document;
+
+		if ( !document.parse( data, size, capacity ) ) {
+			error = DecodeErrorParse;
+			return s_unknown;
+		}
 
-		WsMessage * r = nullptr;
+		auto & v = document.Root();
+		JsonValue body = v;
+		std::shared_ptr<WsMessage> r;
+		std::string_view ch;
 
 		if ( isV2 ) {
-			auto & o = v.get_object();
-			auto action = o["action"].get_string();
+			std::string_view action;
+
+			if ( !v.stringField( "action", action ) ) {
+				error = DecodeErrorMissingField;
+				return s_unknown;
+			}
 
 			if ( "ping" == action ) {
-				r = new WsMessagePingV2;
-				v1 = o["data"];
+				if ( !v.field( "data", body ) ) {
+					error = DecodeErrorMissingField;
+					return s_unknown;
+				}
+
+				r = make<WsMessagePingV2>( cache );
 			}
 			else if ( "req" == action ) {
-				auto & ch = o["ch"].get_string();
+				if ( v.stringField( "ch", ch ) && "auth" == ch ) {
+					r = make<WsMessageAuthResponse>( cache );
+				}
+			}
+			else if ( "sub" == action ) {
+				int64_t code;
+
+				if ( v.int64Field( "code", code ) && code != 200 ) {
+					error = DecodeErrorResponse;
+				}
+
+				return s_unknown;
+			}
+			else if ( "push" == action ) {
+				if ( !v.stringField( "ch", ch ) ||
+					Channel::classify( ch ).kind !=
+						Channel::KindAccountsUpdate ) {
 
-				if ( "auth" == ch ) {
-					r = new WsMessageAuthResponse;
+					error = DecodeErrorUnknownChannel;
+					return s_unknown;
 				}
+
+				if ( !v.field( "data", body ) ) {
+					error = DecodeErrorMissingField;
+					return s_unknown;
+				}
+
+				r = make<WsMessageAccountUpdate>( cache );
+			}
+		}
+		// market data first, it is nearly all of the traffic
+		else if ( v.stringField( "ch", ch ) ) {
+			switch ( Channel::classify( ch ).kind ) {
+				case Channel::KindBbo:
+					r = make<WsMessagePriceBookTicker>( cache );
+					break;
+
+				case Channel::KindDepth:
+					r = make<WsMessageDepth>( cache );
+					break;
+
+				case Channel::KindTrade:
+					r = make<WsMessageTrade>( cache );
+					break;
+
+				default:
+					error = DecodeErrorUnknownChannel;
+					return s_unknown;
 			}
 		}
 		else {
-			auto & o = v.get_object();
+			JsonValue ping;
+			std::string_view status;
 
-			if ( o.contains( "ping" ) ) {
-				r = new WsMessagePing;
+			if ( v.field( "ping", ping ) ) {
+				r = make<WsMessagePing>( cache );
 			}
-			else if ( o.contains( "ch" ) ) {
-				auto & ch = o["ch"].get_string();
+			else if ( v.stringField( "status", status ) &&
+				"error" == status ) {
 
-				if ( ch.starts_with( "market." ) && ch.ends_with( ".bbo" ) ) {
-					r = new WsMessagePriceBookTicker;
-				}
+				error = DecodeErrorResponse;
+				return s_unknown;
 			}
 		}
 
-		if ( nullptr == r ) {
+		if ( !r ) {
 			return s_unknown;
 		}
 
-		r->deserialize( v1 );
+		if ( !r->deserialize( body ) ) {
+			error = DecodeErrorMissingField;
+			return s_unknown;
+		}
 
-		return std::shared_ptr<::as::cryptox::WsMessage>( r );
+		return r;
 	}
 
 	////
 
-	void WsMessagePing::deserialize( boost::json::value & o )
+	bool WsMessagePing::deserialize( JsonValue & v )
 	{
-		m_ts = o.get_object()["ping"].get_int64();
+		int64_t ts;
+
+		if ( !v.int64Field( "ping", ts ) ) {
+			return false;
+		}
+
+		m_ts = static_cast<uint64_t>( ts );
+
+		return true;
 	}
 
 	////
 
-	void WsMessagePingV2::deserialize( boost::json::value & o )
+	bool WsMessagePingV2::deserialize( JsonValue & v )
 	{
-		m_ts = o.get_object()["ts"].get_int64();
+		int64_t ts;
+
+		if ( !v.int64Field( "ts", ts ) ) {
+			return false;
+		}
+
+		m_ts = static_cast<uint64_t>( ts );
+
+		return true;
 	}
 
 	////
 
-	void WsMessagePriceBookTicker::deserialize( boost::json::value & v )
+	bool WsMessagePriceBookTicker::deserialize( JsonValue & v )
 	{
-		auto & o = v.get_object()["tick"].get_object();
-		m_askPrice.Value( o["ask"].get_double() );
-		m_askSize.Value( o["askSize"].get_double() );
-		m_bidPrice.Value( o["bid"].get_double() );
-		m_bidSize.Value( o["bidSize"].get_double() );
-		m_symbolName.assign( o["symbol"].get_string() );
+		JsonValue tick;
+		std::string_view symbolName;
+		int64_t seqId;
+		double askPrice;
+		double askSize;
+		double bidPrice;
+		double bidSize;
+
+		if ( !v.int64Field( "ts", m_ts ) || !v.field( "tick", tick ) ||
+			!tick.int64Field( "seqId", seqId ) ||
+			!tick.doubleField( "ask", askPrice ) ||
+			!tick.doubleField( "askSize", askSize ) ||
+			!tick.doubleField( "bid", bidPrice ) ||
+			!tick.doubleField( "bidSize", bidSize ) ||
+			!tick.stringField( "symbol", symbolName ) ) {
+
+			return false;
+		}
+
+		m_seqId = static_cast<uint64_t>( seqId );
+		m_values = { askPrice, askSize, bidPrice, bidSize };
+		m_askPrice.Value( askPrice );
+		m_askSize.Value( askSize );
+		m_bidPrice.Value( bidPrice );
+		m_bidSize.Value( bidSize );
+		m_symbolName.assign( symbolName.data(), symbolName.size() );
+
+		return true;
 	}
 
 	////
 
-	void WsMessageAccountNotifications::deserialize( boost::json::value & o )
+	bool WsMessageDepth::deserialize( JsonValue & v )
 	{
+		JsonValue tick;
+		int64_t version;
+
+		if ( !channelSymbolName( v, m_symbolName ) ||
+			!v.int64Field( "ts", m_depth.ts ) || !v.field( "tick", tick ) ||
+			!levelsField( tick, "bids", m_depth.bids, m_depth.bidCount ) ||
+			!levelsField( tick, "asks", m_depth.asks, m_depth.askCount ) ||
+			!tick.int64Field( "version", version ) ) {
+
+			return false;
+		}
+
+		m_depth.version = static_cast<uint64_t>( version );
+
+		return true;
 	}
 
 	////
 
-	void WsMessageAuthResponse::deserialize( boost::json::value & v )
+	bool WsMessageTrade::deserialize( JsonValue & v )
 	{
-		auto & o = v.get_object();
-		m_isOk = o["code"].get_int64() == 200;
+		JsonValue tick;
+		JsonValue data;
+		bool isOk = true;
+
+		if ( !channelSymbolName( v, m_symbolName ) ||
+			!v.field( "tick", tick ) || !tick.field( "data", data ) ) {
+
+			return false;
+		}
+
+		m_trades.clear();
+		m_lastTradeId = 0;
+
+		isOk = data.forEach( [&]( JsonValue & e ) {
+			t_trade t;
+			int64_t tradeId;
+			std::string_view direction;
+
+			if ( !e.int64Field( "ts", t.ts ) ||
+				!e.int64Field( "tradeId", tradeId ) ||
+				!e.doubleField( "amount", t.amount ) ||
+				!e.doubleField( "price", t.price ) ||
+				!e.stringField( "direction", direction ) ) {
+
+				isOk = false;
+				return false;
+			}
+
+			t.tradeId = static_cast<uint64_t>( tradeId );
+			t.isBuy = "buy" == direction;
+
+			m_lastTradeId = ( std::max )( m_lastTradeId, t.tradeId );
+			m_trades.push_back( t );
+
+			return true;
+		} ) && isOk;
+
+		return isOk;
+	}
+
+	////
+
+	bool WsMessageAccountNotifications::deserialize( JsonValue & )
+	{
+
+
+		return true;
+	}
+
+	////
+
+	bool WsMessageAccountUpdate::deserialize( JsonValue & v )
+	{
+		std::string_view currencyName;
+
+		if ( !v.stringField( "currency", currencyName ) ||
+			!v.int64Field( "accountId", m_accountId ) ||
+			!amountField( v, "balance", m_balance ) ||
+			!amountField( v, "available", m_available ) ) {
+
+			return false;
+		}
+
+		// null on the initial push after subscribing
+		if ( !v.int64Field( "changeTime", m_changeTime ) ) {
+			m_changeTime = 0;
+		}
+
+		m_currencyName.assign( currencyName.data(), currencyName.size() );
+
+		return true;
+	}
+
+	////
+
+	bool WsMessageAuthResponse::deserialize( JsonValue & v )
+	{
+		int64_t code;
+
+		if ( !v.int64Field( "code", code ) ) {
+			return false;
+		}
+
+		m_isOk = code == 200;
+
+		return true;
 	}
 
 } // namespace as::cryptox::huobi